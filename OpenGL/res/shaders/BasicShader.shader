@@ -4,13 +4,31 @@
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec2 texCoord;
 
+#ifdef INSTANCED
+// Per instance, model takes locations 2-5
+layout(location = 2) in mat4 model;
+layout(location = 6) in vec4 tint;
+#endif
+
 out vec2 v_TexCoord;
+out vec4 v_Tint;
+
+#include "include/Camera.glsl"
 
-uniform mat4 u_MVP;
+#ifndef INSTANCED
+uniform mat4 u_Model;
+uniform vec4 u_Color;
+#endif
 
 void main()
 {
-	gl_Position = u_MVP * position;
+#ifdef INSTANCED
+	gl_Position = u_ViewProjection * model * position;
+	v_Tint = tint;
+#else
+	gl_Position = u_ViewProjection * u_Model * position;
+	v_Tint = u_Color;
+#endif
 	v_TexCoord = texCoord;
 }
 
@@ -21,12 +39,12 @@ void main()
 layout(location = 0) out vec4 color;
 
 in vec2 v_TexCoord;
+in vec4 v_Tint;
 
-uniform vec4 u_Color;
 uniform sampler2D u_Texture;
 
 void main()
 {
 	vec4 texColor = texture(u_Texture, v_TexCoord);
-	color = texColor + u_Color;
+	color = texColor + v_Tint;
 }
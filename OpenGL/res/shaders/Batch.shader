@@ -0,0 +1,71 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+layout(location = 3) in float texIndex;
+layout(location = 4) in float layer;
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+flat out int v_TexIndex;
+flat out int v_Layer;
+
+#include "include/Camera.glsl"
+
+void main()
+{
+	gl_Position = u_ViewProjection * vec4(position, 0.0, 1.0);
+	v_TexCoord = texCoord;
+	v_Color = color;
+	v_TexIndex = int(texIndex);
+	v_Layer = int(layer);
+}
+
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+in vec4 v_Color;
+flat in int v_TexIndex;
+flat in int v_Layer;
+
+// The batch's TextureArray, for quads with a layer of 0 or more
+uniform sampler2DArray u_Layers;
+
+uniform sampler2D u_Textures[15]; // With u_Layers, the 16 samplers GL 3.3 guarantees
+
+void main()
+{
+	if (v_Layer >= 0)
+	{
+		color = texture(u_Layers, vec3(v_TexCoord, v_Layer)) * v_Color;
+		return;
+	}
+
+	// GLSL 330 only allows constant sampler array indices, so select the slot with a switch
+	vec4 texColor;
+	switch (v_TexIndex)
+	{
+		case 0:  texColor = texture(u_Textures[0],  v_TexCoord); break;
+		case 1:  texColor = texture(u_Textures[1],  v_TexCoord); break;
+		case 2:  texColor = texture(u_Textures[2],  v_TexCoord); break;
+		case 3:  texColor = texture(u_Textures[3],  v_TexCoord); break;
+		case 4:  texColor = texture(u_Textures[4],  v_TexCoord); break;
+		case 5:  texColor = texture(u_Textures[5],  v_TexCoord); break;
+		case 6:  texColor = texture(u_Textures[6],  v_TexCoord); break;
+		case 7:  texColor = texture(u_Textures[7],  v_TexCoord); break;
+		case 8:  texColor = texture(u_Textures[8],  v_TexCoord); break;
+		case 9:  texColor = texture(u_Textures[9],  v_TexCoord); break;
+		case 10: texColor = texture(u_Textures[10], v_TexCoord); break;
+		case 11: texColor = texture(u_Textures[11], v_TexCoord); break;
+		case 12: texColor = texture(u_Textures[12], v_TexCoord); break;
+		case 13: texColor = texture(u_Textures[13], v_TexCoord); break;
+		default: texColor = texture(u_Textures[14], v_TexCoord); break;
+	}
+	color = texColor * v_Color;
+}
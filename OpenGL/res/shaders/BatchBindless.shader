@@ -0,0 +1,58 @@
+#shader vertex
+#version 400 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+layout(location = 3) in float texIndex;
+layout(location = 4) in float layer;
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+flat out int v_TexIndex;
+flat out int v_Layer;
+
+#include "include/Camera.glsl"
+
+void main()
+{
+	gl_Position = u_ViewProjection * vec4(position, 0.0, 1.0);
+	v_TexCoord = texCoord;
+	v_Color = color;
+	v_TexIndex = int(texIndex);
+	v_Layer = int(layer);
+}
+
+
+#shader fragment
+#version 400 core
+#extension GL_ARB_bindless_texture : require
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+in vec4 v_Color;
+flat in int v_TexIndex;
+flat in int v_Layer;
+
+// The batch's TextureArray, for quads with a layer of 0 or more
+uniform sampler2DArray u_Layers;
+
+// 64 bit handles as low/high pairs, two per element since std140 pads uvec2 arrays to 16 bytes
+layout(std140) uniform TextureHandles
+{
+	uvec4 u_Handles[512]; // BatchRenderer::MaxBindlessTextures / 2
+};
+
+void main()
+{
+	if (v_Layer >= 0)
+	{
+		color = texture(u_Layers, vec3(v_TexCoord, v_Layer)) * v_Color;
+		return;
+	}
+
+	uvec4 pair = u_Handles[v_TexIndex >> 1];
+	uvec2 handle = (v_TexIndex & 1) == 0 ? pair.xy : pair.zw;
+	color = texture(sampler2D(handle), v_TexCoord) * v_Color;
+}
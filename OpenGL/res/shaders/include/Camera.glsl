@@ -0,0 +1,7 @@
+// Shared by every shader, filled once per frame by Renderer::SetCamera
+layout(std140) uniform Camera
+{
+	mat4 u_Projection;
+	mat4 u_View;
+	mat4 u_ViewProjection;
+};
@@ -13,6 +13,17 @@
 #include "VertexArray.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "BatchRenderer.h"
+#include "GLState.h"
+#include "GLDebug.h"
+#include "GPUMemory.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderWatcher.h"
+#include "ShaderLibrary.h"
+#include "TextureLoader.h"
+#include "TextureLibrary.h"
+#include "TextureAtlas.h"
+#include "TextureArray.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -38,6 +49,11 @@ int main(void)
     //glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); 
     //glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     //glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#if GL_ERROR_CHECK
+    // Some drivers only produce KHR_debug output on debug contexts
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
     
     /* Create a windowed mode window and its OpenGL context */
     window = glfwCreateWindow(960, 540, "OpenGL Practice", NULL, NULL);
@@ -59,6 +75,11 @@ int main(void)
     // Output OpenGL info
     std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
 
+#if GL_ERROR_CHECK
+    // Synchronous so a break lands on the offending call, falls back to GLCall polling without KHR_debug
+    GLDebug::Init(GL_ERROR_CHECK >= 2);
+#endif
+
 
     ///////////////// Graphics Data /////////////////
     /////////////////////////////////////////////////
@@ -84,8 +105,8 @@ int main(void)
         layout.Push<float>(2);
 
         // Blending for transperency
-        GLCall(glEnable(GL_BLEND));
-        GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+        GLState::SetBlend(true);
+        GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         //// Vertex Array and Buffer Objects ////
         VertexBuffer vbo(vertexBufferData, 4 * 4 * sizeof(float));
@@ -93,6 +114,23 @@ int main(void)
 
         vao.AddBuffer(vbo, layout);
 
+        // Per instance data, advances once per instance instead of per vertex
+        struct InstanceData
+        {
+            glm::mat4 Model;
+            glm::vec4 Tint;
+        };
+        const unsigned int instanceCount = 2;
+        InstanceData instances[instanceCount];
+
+        VertexBufferLayout instanceLayout;
+        instanceLayout.SetDivisor(1);
+        instanceLayout.Push<float>(16); // Model
+        instanceLayout.Push<float>(4);  // Tint
+
+        VertexBuffer instanceVbo(nullptr, sizeof(instances), BufferUsage::Dynamic);
+        vao.AddBuffer(instanceVbo, instanceLayout);
+
 
         //// Index Buffer ////
         IndexBuffer ibo(indexBufferData, 6);
@@ -103,12 +141,40 @@ int main(void)
         
 
         //// Shader ////
-        Shader shader("res/shaders/BasicShader.Shader");
+        ProgramBinaryCache::SetDirectory("res/shaders/cache");
+        Shader::EnableParallelCompile();
+
+        // Kick off every compile before using any, so they overlap in the driver.
+        // Instancing is a permutation of the basic shader rather than a runtime branch
+        ShaderLibrary shaderLibrary;
+        Shader& shader = shaderLibrary.Get("res/shaders/BasicShader.shader", {}, true);
+        Shader& instancedShader = shaderLibrary.Get("res/shaders/BasicShader.shader", { "INSTANCED" }, true);
+
         shader.Bind();
         shader.SetUniform1i("u_Texture", 0);
-
-        // Texture
-        Texture texture("res/textures/hk.png");
+        shader.SetUniformBlockBinding("Camera", Renderer::CameraBinding);
+
+        instancedShader.Bind();
+        instancedShader.SetUniform1i("u_Texture", 0);
+        instancedShader.SetUniformBlockBinding("Camera", Renderer::CameraBinding);
+
+        // Both draw from vao, the instance attributes start after the mesh's two
+        shader.ValidateLayout(layout);
+        instancedShader.ValidateLayout(layout);
+        instancedShader.ValidateLayout(instanceLayout, 2);
+
+        // Texture, decoded on a worker thread and uploaded a few per frame
+        TextureLoader textureLoader;
+        // Everything asking for the same image shares one texture
+        TextureLibrary textureLibrary(&textureLoader);
+        // The sprite grid draws it tiny, mips keep that from shimmering and thrashing the cache
+        TextureSpec textureSpec;
+        textureSpec.Mipmaps = TextureMipmaps::GPU;
+        textureSpec.Anisotropy = 8.0f;
+        // Prefer the copy TextureBaker made, it maps straight in with its mips and skips decoding
+        std::string hkPath = std::ifstream("res/textures/hk.ktx2").good() ? "res/textures/hk.ktx2" : "res/textures/hk.png";
+        std::shared_ptr<Texture> hkTexture = textureLibrary.Get(hkPath, textureSpec);
+        Texture& texture = *hkTexture;
         texture.Bind();
 
 
@@ -117,8 +183,41 @@ int main(void)
         vao.Unbind();
         ibo.Unbind();
         shader.Unbind();
+        instancedShader.Unbind();
 
         Renderer renderer;
+        BatchRenderer batchRenderer;
+
+        // Generated tiles packed into one page, and the same tiles as layers of an array,
+        // so the sprite grid can mix all of them in one batch either way
+        const int tileSize = 16;
+        const int tileCount = 32;
+        TextureAtlas tileAtlas(256);
+        TextureArray tileArray(tileSize, tileSize, tileCount);
+        std::vector<unsigned int> tiles;
+        for (int i = 0; i < tileCount; i++)
+        {
+            unsigned char pixels[tileSize * tileSize * 4];
+            for (int y = 0; y < tileSize; y++)
+            {
+                for (int x = 0; x < tileSize; x++)
+                {
+                    unsigned char* pixel = pixels + (y * tileSize + x) * 4;
+                    bool light = ((x / 4) + (y / 4)) % 2 == 0;
+                    pixel[0] = (unsigned char)(light ? 255 : (i * 37) % 256);
+                    pixel[1] = (unsigned char)(light ? 255 : (i * 91) % 256);
+                    pixel[2] = (unsigned char)(light ? 255 : (i * 53) % 256);
+                    pixel[3] = 255;
+                }
+            }
+            tiles.push_back(tileAtlas.Add("tile" + std::to_string(i), tileSize, tileSize, pixels));
+            tileArray.SetLayer(i, pixels);
+        }
+        tileAtlas.Build();
+
+        // Edit a .shader file while running to see it recompile
+        ShaderWatcher shaderWatcher;
+        shaderLibrary.ForEach([&shaderWatcher](Shader& permutation) { shaderWatcher.Watch(permutation); });
         
         //// ImGui ////
 
@@ -135,12 +234,25 @@ int main(void)
         glm::vec4 tintColor(0);
         glm::vec3 translation(0);
         glm::vec3 translation2(100, 100 ,0);
+        int spriteCount = 0;
+        enum SpriteSource { SingleTexture = 0, AtlasTiles = 1, ArrayTiles = 2 };
+        int spriteSource = SingleTexture;
+        GLState::Stats lastFrameStateStats; // The live counters restart every frame, show the last full one
+        enum DrawMode { Immediate = 0, Instanced = 1, Queued = 2 };
+        int drawMode = Instanced;
 
         while (!glfwWindowShouldClose(window))
         {
             // Clear
             renderer.Clear();
 
+            shaderWatcher.Update();
+            textureLoader.Update();
+            textureLibrary.Trim();
+
+            // Camera goes into the ring once per frame for every shader
+            renderer.SetCamera(proj, view);
+
             // ImGui New Frame
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
@@ -156,26 +268,94 @@ int main(void)
                 ImGui::SliderFloat3("Pic 1", &translation.x, 0.0f, 960.0f);
                 ImGui::SliderFloat3("Pic 2", &translation2.x, 0.0f, 960.0f);
                 ImGui::ColorEdit3("Tint", (float*)&tintColor);
+                ImGui::RadioButton("Immediate", &drawMode, Immediate); ImGui::SameLine();
+                ImGui::RadioButton("Instanced", &drawMode, Instanced); ImGui::SameLine();
+                ImGui::RadioButton("Queued", &drawMode, Queued);
+                ImGui::SliderInt("Sprites", &spriteCount, 0, 50000);
+                ImGui::RadioButton("Texture", &spriteSource, SingleTexture); ImGui::SameLine();
+                ImGui::RadioButton("Atlas tiles", &spriteSource, AtlasTiles); ImGui::SameLine();
+                ImGui::RadioButton("Array tiles", &spriteSource, ArrayTiles);
+
+                const BatchRenderer::Stats& stats = batchRenderer.GetStats();
+                const Renderer::QueueStats& queueStats = renderer.GetQueueStats();
+                ImGui::Text("Queue: %u submitted, %u draw calls", queueStats.Submitted, queueStats.DrawCalls);
+                ImGui::Text("Batch: %u draw calls, %u quads%s", stats.DrawCalls, stats.QuadCount, batchRenderer.IsBindless() ? ", bindless" : "");
+
+                // Counted over the previous frame
+                ImGui::Text("GL state: %u issued, %u skipped", lastFrameStateStats.Issued, lastFrameStateStats.Skipped);
+                const PixelBufferRing::Stats& uploadStats = textureLoader.GetUploadRing().GetStats();
+                ImGui::Text("Textures loading: %u, %u streamed, %u stalls", textureLoader.GetPendingCount(), uploadStats.Uploads, uploadStats.Stalls);
+                const GPUMemory::Stats& memory = GPUMemory::GetTotal();
+                ImGui::Text("GPU memory: %.1f MB in %u objects, peak %.1f MB", memory.Bytes / (1024.0 * 1024.0), memory.Count, memory.PeakBytes / (1024.0 * 1024.0));
+                ImGui::SameLine();
+                if (ImGui::Button("Report"))
+                    GPUMemory::Report();
+                const TextureLibrary::Stats& libraryStats = textureLibrary.GetStats();
+                ImGui::Text("Texture library: %zu textures, %.1f MB, %u hits, %u deduplicated, %u evicted", textureLibrary.GetCount(),
+                    textureLibrary.GetMemoryUsage() / (1024.0 * 1024.0), libraryStats.Hits, textureLoader.GetDeduplicatedCount(), libraryStats.Evictions);
 
                 ImGui::End();
             }
 
             // Hollow Knight
-            shader.Bind();
-            shader.SetUniform4f("u_Color", tintColor);
+            texture.Bind();
 
+            renderer.ResetQueueStats();
+            if (drawMode == Instanced)
             {
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
-                glm::mat4 mvp = proj * view * model;
-                shader.SetUniformMat4f("u_MVP", mvp);
-                renderer.Draw(vao, ibo, shader);
+                // Both copies in one draw call
+                instances[0] = { glm::translate(glm::mat4(1.0f), translation), tintColor };
+                instances[1] = { glm::translate(glm::mat4(1.0f), translation2), tintColor };
+                instanceVbo.SetData(0, instances, sizeof(instances));
+
+                renderer.DrawInstanced(vao, ibo, instancedShader, instanceCount);
+            }
+            else if (drawMode == Queued)
+            {
+                // Submitted front first, the queue still blends them back to front
+                renderer.BeginScene();
+                renderer.Submit(vao, ibo, shader, texture, glm::translate(glm::mat4(1.0f), translation2), tintColor, 0, true, 0.25f);
+                renderer.Submit(vao, ibo, shader, texture, glm::translate(glm::mat4(1.0f), translation), tintColor, 0, true, 0.75f);
+                renderer.EndScene();
+            }
+            else
+            {
+                shader.Bind();
+                shader.SetUniform4f("u_Color", tintColor);
+
+                {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
+                    shader.SetUniformMat4f("u_Model", model);
+                    renderer.Draw(vao, ibo, shader);
+                }
+
+                {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), translation2);
+                    shader.SetUniformMat4f("u_Model", model);
+                    renderer.Draw(vao, ibo, shader);
+                }
             }
 
+            // Sprite grid, one draw call per batch
+            batchRenderer.ResetStats();
+            if (spriteCount > 0)
             {
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), translation2);
-                glm::mat4 mvp = proj * view * model;
-                shader.SetUniformMat4f("u_MVP", mvp);
-                renderer.Draw(vao, ibo, shader);
+                batchRenderer.Begin();
+
+                const int columns = 200;
+                const glm::vec2 spriteSize(4.8f, 2.7f);
+                for (int i = 0; i < spriteCount; i++)
+                {
+                    glm::vec2 position((i % columns) * spriteSize.x, (i / columns) * spriteSize.y);
+                    if (spriteSource == AtlasTiles)
+                        batchRenderer.DrawQuad(position, spriteSize, tileAtlas.GetRegion(tiles[i % tiles.size()]), glm::vec4(1.0f) + tintColor);
+                    else if (spriteSource == ArrayTiles)
+                        batchRenderer.DrawQuad(position, spriteSize, tileArray, i % tileCount, glm::vec4(1.0f) + tintColor);
+                    else
+                        batchRenderer.DrawQuad(position, spriteSize, texture, glm::vec4(1.0f) + tintColor);
+                }
+
+                batchRenderer.End();
             }
 
 
@@ -184,6 +364,14 @@ int main(void)
             // ImGui
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            renderer.EndFrame();
+
+            // ImGui restores the bindings it touches, but without going through the cache
+            GLState::Invalidate();
+            lastFrameStateStats = GLState::GetStats();
+            GLState::ResetStats();
+
+            GLCheckErrors("end of frame");
 
             // Swap Buffers
             glfwSwapBuffers(window);
@@ -193,10 +381,17 @@ int main(void)
 
         }
     }
+
+    // Everything owned by the scope above is gone, whatever is left leaked
+    if (GPUMemory::GetTotal().Count > 0)
+        GPUMemory::Report();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    GLDebug::Shutdown();
+
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+
+#include <cstring>
+
+static std::vector<unsigned int> BuildQuadIndices(unsigned int quadCount)
+{
+    // Same winding as a single quad: 0, 1, 2, 2, 3, 0
+    std::vector<unsigned int> indices(quadCount * 6);
+    for (unsigned int i = 0, offset = 0; i < quadCount * 6; i += 6, offset += 4)
+    {
+        indices[i + 0] = offset + 0;
+        indices[i + 1] = offset + 1;
+        indices[i + 2] = offset + 2;
+        indices[i + 3] = offset + 2;
+        indices[i + 4] = offset + 3;
+        indices[i + 5] = offset + 0;
+    }
+    return indices;
+}
+
+static const unsigned char s_WhitePixel[4] = { 255, 255, 255, 255 };
+
+BatchRenderer::BatchRenderer()
+    : m_IndexBuffer(BuildQuadIndices(MaxQuads).data(), MaxIndices),
+      m_Bindless(Texture::IsBindlessSupported()),
+      m_Shader(m_Bindless ? "res/shaders/BatchBindless.shader" : "res/shaders/Batch.shader"),
+      m_WhiteTexture(1, 1, s_WhitePixel),
+      m_TextureSlotCount(0),
+      m_LayerArray(nullptr),
+      m_HandleAlignment(1)
+{
+    VertexBufferLayout layout;
+    layout.Push<float>(2); // Position
+    layout.Push<float>(2); // TexCoord
+    layout.Push<float>(4); // Color
+    layout.Push<float>(1); // TexIndex
+    layout.Push<float>(1); // Layer
+    if (RingBuffer::IsSupported())
+    {
+        // Each region holds two full batches, frames drawing more wrap early and may wait on the GPU
+        m_VertexRing.reset(new RingBuffer(GL_ARRAY_BUFFER, 2 * MaxVertices * sizeof(BatchVertex), 3));
+        m_VertexArray.AddBuffer(*m_VertexRing, layout);
+    }
+    else
+    {
+        m_VertexBuffer.reset(new VertexBuffer(nullptr, MaxVertices * sizeof(BatchVertex), BufferUsage::Stream));
+        m_VertexArray.AddBuffer(*m_VertexBuffer, layout);
+    }
+
+    m_Vertices.reserve(MaxVertices);
+
+    m_Shader.ValidateLayout(layout);
+    m_Shader.Bind();
+    if (m_Bindless)
+    {
+        if (RingBuffer::IsSupported())
+        {
+            GLint alignment;
+            GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+            m_HandleAlignment = alignment;
+
+            // Room for sixteen batches per region
+            size_t blockSize = (MaxBindlessTextures * sizeof(uint64_t) + m_HandleAlignment - 1) / m_HandleAlignment * m_HandleAlignment;
+            m_HandleRing.reset(new RingBuffer(GL_UNIFORM_BUFFER, 16 * blockSize, 3));
+        }
+        else
+        {
+            m_HandleBuffer.reset(new UniformBuffer(MaxBindlessTextures * sizeof(uint64_t), Renderer::TextureHandleBinding));
+        }
+        m_Handles.reserve(MaxBindlessTextures);
+        m_Shader.SetUniformBlockBinding("TextureHandles", Renderer::TextureHandleBinding);
+    }
+    else
+    {
+        // Slot i samples texture unit FirstTextureUnit + i
+        int samplers[MaxTextureSlots];
+        for (int i = 0; i < (int)MaxTextureSlots; i++)
+            samplers[i] = FirstTextureUnit + i;
+        m_Shader.SetUniform1iv("u_Textures", MaxTextureSlots, samplers);
+    }
+    m_Shader.SetUniform1i("u_Layers", LayerArrayUnit);
+    m_Shader.SetUniformBlockBinding("Camera", Renderer::CameraBinding);
+    m_Shader.Unbind();
+    m_VertexArray.Unbind();
+
+    StartBatch();
+}
+
+void BatchRenderer::Begin()
+{
+    StartBatch();
+}
+
+void BatchRenderer::End()
+{
+    Flush();
+
+    if (m_VertexRing)
+        m_VertexRing->EndFrame();
+    if (m_HandleRing)
+        m_HandleRing->EndFrame();
+}
+
+void BatchRenderer::ResetStats()
+{
+    m_Stats = Stats();
+}
+
+void BatchRenderer::StartBatch()
+{
+    m_Vertices.clear();
+
+    // Slot 0 is always the white texture for untextured quads
+    m_TextureSlots[0] = &m_WhiteTexture;
+    m_TextureSlotCount = 1;
+    m_LayerArray = nullptr;
+
+    if (m_Bindless)
+    {
+        m_Handles.clear();
+        m_HandleSlots.clear();
+        GetHandleIndex(m_WhiteTexture);
+    }
+}
+
+void BatchRenderer::Flush()
+{
+    if (m_Vertices.empty())
+        return;
+
+    unsigned int size = (unsigned int)(m_Vertices.size() * sizeof(BatchVertex));
+    int baseVertex = 0;
+    if (m_VertexRing)
+    {
+        // Stride aligned, so the range starts on a whole vertex the draw can offset to
+        RingBuffer::Allocation range = m_VertexRing->Write(m_Vertices.data(), size, sizeof(BatchVertex));
+        baseVertex = (int)(range.Offset / sizeof(BatchVertex));
+    }
+    else
+    {
+        // Upload only the part of the vertex stream used this batch. Orphaning first means the
+        // previous batch's draw can still be reading the old storage without a stall.
+        m_VertexBuffer->Stream(m_Vertices.data(), size);
+    }
+
+    if (m_HandleRing)
+    {
+        // The bound range has to cover the whole block even though only the start is used
+        RingBuffer::Allocation range = m_HandleRing->Allocate(MaxBindlessTextures * sizeof(uint64_t), m_HandleAlignment);
+        memcpy(range.Data, m_Handles.data(), m_Handles.size() * sizeof(uint64_t));
+        m_HandleRing->BindRange(Renderer::TextureHandleBinding, range);
+    }
+    else if (m_Bindless)
+    {
+        m_HandleBuffer->SetData(m_Handles.data(), (unsigned int)(m_Handles.size() * sizeof(uint64_t)));
+    }
+    else
+    {
+        for (unsigned int i = 0; i < m_TextureSlotCount; i++)
+            m_TextureSlots[i]->Bind(FirstTextureUnit + i);
+    }
+
+    // Sampled from its unit with or without bindless
+    if (m_LayerArray)
+        m_LayerArray->Bind(LayerArrayUnit);
+
+    unsigned int quadCount = (unsigned int)m_Vertices.size() / 4;
+
+    m_Shader.Bind();
+    m_VertexArray.Bind();
+    m_IndexBuffer.Bind();
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, nullptr, baseVertex));
+
+    m_Stats.DrawCalls++;
+    m_Stats.QuadCount += quadCount;
+
+    StartBatch();
+}
+
+float BatchRenderer::GetTextureIndex(const Texture& texture)
+{
+    if (m_Bindless)
+        return GetHandleIndex(texture);
+
+    for (unsigned int i = 0; i < m_TextureSlotCount; i++)
+    {
+        if (m_TextureSlots[i] == &texture)
+            return (float)i;
+    }
+
+    // Out of slots, draw what we have and start a new batch
+    if (m_TextureSlotCount == MaxTextureSlots)
+        Flush();
+
+    m_TextureSlots[m_TextureSlotCount] = &texture;
+    return (float)m_TextureSlotCount++;
+}
+
+float BatchRenderer::GetHandleIndex(const Texture& texture)
+{
+    // Keyed by handle, every texture still loading shares the placeholder's slot
+    uint64_t handle = texture.GetBindlessHandle();
+    auto found = m_HandleSlots.find(handle);
+    if (found != m_HandleSlots.end())
+        return (float)found->second;
+
+    if (m_Handles.size() == MaxBindlessTextures)
+        Flush();
+
+    unsigned int index = (unsigned int)m_Handles.size();
+    m_Handles.push_back(handle);
+    m_HandleSlots[handle] = index;
+    return (float)index;
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+    PushQuad(position, size, 0.0f, glm::vec2(0.0f), glm::vec2(1.0f), color);
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture, const glm::vec4& tint)
+{
+    DrawQuad(position, size, texture, glm::vec2(0.0f), glm::vec2(1.0f), tint);
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture,
+    const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& tint)
+{
+    if (m_Vertices.size() == MaxVertices)
+        Flush();
+
+    float texIndex = GetTextureIndex(texture);
+    PushQuad(position, size, texIndex, uvMin, uvMax, tint);
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const AtlasRegion& region, const glm::vec4& tint)
+{
+    // Didn't fit a page when the atlas was built, that already warned
+    if (!region.Page)
+        return;
+
+    DrawQuad(position, size, *region.Page, region.UVMin, region.UVMax, tint);
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const TextureArray& array, int layer, const glm::vec4& tint)
+{
+    if (m_Vertices.size() == MaxVertices)
+        Flush();
+
+    if (m_LayerArray && m_LayerArray != &array)
+        Flush();
+    m_LayerArray = &array;
+
+    PushQuad(position, size, 0.0f, glm::vec2(0.0f), glm::vec2(1.0f), tint, (float)layer);
+}
+
+void BatchRenderer::PushQuad(const glm::vec2& position, const glm::vec2& size, float texIndex,
+    const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& color, float layer)
+{
+    if (m_Vertices.size() == MaxVertices)
+        Flush();
+
+    m_Vertices.push_back({ position, uvMin, color, texIndex, layer });
+    m_Vertices.push_back({ { position.x + size.x, position.y }, { uvMax.x, uvMin.y }, color, texIndex, layer });
+    m_Vertices.push_back({ position + size, uvMax, color, texIndex, layer });
+    m_Vertices.push_back({ { position.x, position.y + size.y }, { uvMin.x, uvMax.y }, color, texIndex, layer });
+}
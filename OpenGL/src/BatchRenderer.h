@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "RingBuffer.h"
+#include "TextureAtlas.h"
+#include "TextureArray.h"
+
+struct BatchVertex
+{
+	glm::vec2 Position;
+	glm::vec2 TexCoord;
+	glm::vec4 Color;
+	float TexIndex;
+	float Layer; // Into the batch's TextureArray, -1 samples TexIndex instead
+};
+
+// Accumulates quads on the CPU and draws them with one glDrawElements per batch.
+// A batch is flushed when it runs out of quads or texture slots, or on End().
+// With ARB_bindless_texture the slots are handles in a uniform buffer instead of
+// texture units, so a batch can use up to MaxBindlessTextures textures. Without it,
+// same sized textures can go into a TextureArray: a batch binds one array next to
+// its slots, and any number of its layers costs no slot at all.
+// Vertices stream through a persistently mapped RingBuffer and each batch draws
+// from its own range with a base vertex. Without buffer storage they go through
+// an orphaned VertexBuffer instead.
+class BatchRenderer
+{
+public:
+	static const unsigned int MaxQuads = 10000;
+	static const unsigned int MaxVertices = MaxQuads * 4;
+	static const unsigned int MaxIndices = MaxQuads * 6;
+	// Must match u_Textures in Batch.shader, with the array it's the 16 samplers GL 3.3 guarantees
+	static const unsigned int MaxTextureSlots = 15;
+	// Slots use the units from here on, unit 0 is left to whatever the caller bound there
+	static const unsigned int FirstTextureUnit = 1;
+	static const unsigned int LayerArrayUnit = FirstTextureUnit + MaxTextureSlots;
+	static const unsigned int MaxBindlessTextures = 1024; // Must match u_Handles in BatchBindless.shader
+
+	struct Stats
+	{
+		unsigned int DrawCalls = 0;
+		unsigned int QuadCount = 0;
+	};
+
+private:
+	VertexArray m_VertexArray;
+	std::unique_ptr<RingBuffer> m_VertexRing;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer; // Only without a ring
+	IndexBuffer m_IndexBuffer;
+	bool m_Bindless;
+	Shader m_Shader;
+	Texture m_WhiteTexture;
+
+	std::vector<BatchVertex> m_Vertices;
+	const Texture* m_TextureSlots[MaxTextureSlots];
+	unsigned int m_TextureSlotCount;
+	const TextureArray* m_LayerArray; // Null until a quad in the batch uses one
+
+	// Bindless only, the batch's handles in slot order
+	std::unique_ptr<RingBuffer> m_HandleRing;
+	std::unique_ptr<UniformBuffer> m_HandleBuffer; // Only without a ring
+	size_t m_HandleAlignment;
+	std::vector<uint64_t> m_Handles;
+	std::unordered_map<uint64_t, unsigned int> m_HandleSlots;
+
+	Stats m_Stats;
+
+public:
+	BatchRenderer();
+
+	// The camera comes from the Renderer's Camera uniform block. Call once per frame,
+	// End() also hands the ring region this frame wrote to the GPU.
+	void Begin();
+	void End();
+
+	// Untinted quads use white, position is the bottom left corner
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture, const glm::vec4& tint = glm::vec4(1.0f));
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture,
+		const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& tint = glm::vec4(1.0f));
+	// Regions sharing an atlas page share a texture slot
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const AtlasRegion& region, const glm::vec4& tint = glm::vec4(1.0f));
+	// One layer of an array. A batch holds one array, switching to another flushes.
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const TextureArray& array, int layer, const glm::vec4& tint = glm::vec4(1.0f));
+
+	inline const Stats& GetStats() const { return m_Stats; }
+	inline bool IsBindless() const { return m_Bindless; }
+	void ResetStats();
+
+private:
+	void Flush();
+	void StartBatch();
+	float GetTextureIndex(const Texture& texture);
+	float GetHandleIndex(const Texture& texture);
+	void PushQuad(const glm::vec2& position, const glm::vec2& size, float texIndex,
+		const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& color, float layer = -1.0f);
+};
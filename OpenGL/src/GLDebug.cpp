@@ -0,0 +1,245 @@
+#include "GLDebug.h"
+#include "Renderer.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+    // Default filter table, applied in order on Init
+    const GLDebug::Filter s_DefaultFilters[] =
+    {
+        // Notifications are mostly "buffer will use video memory" style chatter
+        { GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, false },
+        // NVIDIA buffer detailed info, reported for every buffer upload
+        { GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, GL_DONT_CARE, 131185, false },
+        // NVIDIA "texture object does not have a defined base level" while textures load
+        { GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, GL_DONT_CARE, 131204, false },
+    };
+
+    // Bounded lock-free queue. The driver may call back from several of its
+    // threads at once, so pushes are multi-producer, Poll() is the single consumer.
+    struct Slot
+    {
+        std::atomic<size_t> Sequence;
+        GLDebug::Message Msg;
+    };
+
+    Slot s_Ring[GLDebug::Capacity];
+    std::atomic<size_t> s_Head(0);
+    size_t s_Tail = 0;
+    std::atomic<unsigned int> s_Dropped(0);
+
+    bool s_Active = false;
+    bool s_Synchronous = false;
+
+    void ResetRing()
+    {
+        for (size_t i = 0; i < GLDebug::Capacity; i++)
+            s_Ring[i].Sequence.store(i, std::memory_order_relaxed);
+        s_Head.store(0, std::memory_order_relaxed);
+        s_Tail = 0;
+        s_Dropped.store(0, std::memory_order_relaxed);
+    }
+
+    bool Push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* text)
+    {
+        size_t pos = s_Head.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &s_Ring[pos & (GLDebug::Capacity - 1)];
+            size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                if (s_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // Full, the consumer hasn't caught up
+                s_Dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = s_Head.load(std::memory_order_relaxed);
+            }
+        }
+
+        GLDebug::Message& msg = slot->Msg;
+        msg.Source = source;
+        msg.Type = type;
+        msg.ID = id;
+        msg.Severity = severity;
+        size_t count = length < 0 ? strlen(text) : (size_t)length;
+        if (count >= GLDebug::MaxMessageLength)
+            count = GLDebug::MaxMessageLength - 1;
+        memcpy(msg.Text, text, count);
+        msg.Text[count] = '\0';
+
+        slot->Sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(GLDebug::Message& msg)
+    {
+        Slot& slot = s_Ring[s_Tail & (GLDebug::Capacity - 1)];
+        if (slot.Sequence.load(std::memory_order_acquire) != s_Tail + 1)
+            return false;
+
+        msg = slot.Msg;
+        slot.Sequence.store(s_Tail + GLDebug::Capacity, std::memory_order_release);
+        s_Tail++;
+        return true;
+    }
+
+    const char* SourceName(GLenum source)
+    {
+        switch (source)
+        {
+            case GL_DEBUG_SOURCE_API:               return "API";
+            case GL_DEBUG_SOURCE_WINDOW_SYSTEM:     return "Window System";
+            case GL_DEBUG_SOURCE_SHADER_COMPILER:   return "Shader Compiler";
+            case GL_DEBUG_SOURCE_THIRD_PARTY:       return "Third Party";
+            case GL_DEBUG_SOURCE_APPLICATION:       return "Application";
+        }
+        return "Other";
+    }
+
+    const char* TypeName(GLenum type)
+    {
+        switch (type)
+        {
+            case GL_DEBUG_TYPE_ERROR:               return "Error";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "Undefined Behavior";
+            case GL_DEBUG_TYPE_PORTABILITY:         return "Portability";
+            case GL_DEBUG_TYPE_PERFORMANCE:         return "Performance";
+            case GL_DEBUG_TYPE_MARKER:              return "Marker";
+        }
+        return "Other";
+    }
+
+    const char* SeverityName(GLenum severity)
+    {
+        switch (severity)
+        {
+            case GL_DEBUG_SEVERITY_HIGH:            return "High";
+            case GL_DEBUG_SEVERITY_MEDIUM:          return "Medium";
+            case GL_DEBUG_SEVERITY_LOW:             return "Low";
+        }
+        return "Notification";
+    }
+
+    void Print(const GLDebug::Message& msg)
+    {
+        std::cout << "[OpenGL Debug] (" << SeverityName(msg.Severity) << ") " <<
+            SourceName(msg.Source) << " " <<
+            TypeName(msg.Type) << " " <<
+            msg.ID << ": " <<
+            msg.Text << std::endl;
+    }
+
+    void GLAPIENTRY OnDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+        GLsizei length, const GLchar* message, const void* userParam)
+    {
+        (void)userParam;
+
+        // Synchronous output runs on the offending call, report and break right away
+        if (s_Synchronous && type == GL_DEBUG_TYPE_ERROR)
+        {
+            GLDebug::Poll();
+            std::cout << "[OpenGL Error] (" << id << "): " << message << std::endl;
+            DEBUG_BREAK();
+            return;
+        }
+
+        Push(source, type, id, severity, length, message);
+    }
+
+}
+
+bool GLDebug::Init(bool synchronous)
+{
+    if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug)
+    {
+        std::cout << "GLDebug: KHR_debug not supported, polling glGetError instead" << std::endl;
+        return false;
+    }
+
+    ResetRing();
+
+    GLCall(glEnable(GL_DEBUG_OUTPUT));
+    GLCall(glDebugMessageCallback(OnDebugMessage, nullptr));
+    SetSynchronous(synchronous);
+
+    for (const Filter& filter : s_DefaultFilters)
+        ApplyFilter(filter);
+
+    s_Active = true;
+    return true;
+}
+
+void GLDebug::Shutdown()
+{
+    if (!s_Active)
+        return;
+
+    GLCall(glDebugMessageCallback(nullptr, nullptr));
+    GLCall(glDisable(GL_DEBUG_OUTPUT));
+    s_Active = false;
+    Poll();
+}
+
+bool GLDebug::IsActive()
+{
+    return s_Active;
+}
+
+void GLDebug::SetSynchronous(bool synchronous)
+{
+    s_Synchronous = synchronous;
+    if (synchronous)
+    {
+        GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    else
+    {
+        GLCall(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+}
+
+void GLDebug::ApplyFilter(const Filter& filter)
+{
+    // Filtering happens in the driver, so disabled messages never reach the callback.
+    // Filtering by ID needs a concrete source and type, and severity must be GL_DONT_CARE.
+    if (filter.ID)
+    {
+        GLCall(glDebugMessageControl(filter.Source, filter.Type, GL_DONT_CARE, 1, &filter.ID, filter.Enabled));
+    }
+    else
+    {
+        GLCall(glDebugMessageControl(filter.Source, filter.Type, filter.Severity, 0, nullptr, filter.Enabled));
+    }
+}
+
+unsigned int GLDebug::Poll()
+{
+    unsigned int count = 0;
+    Message msg;
+    while (Pop(msg))
+    {
+        Print(msg);
+        count++;
+    }
+    return count;
+}
+
+unsigned int GLDebug::GetDroppedCount()
+{
+    return s_Dropped.load(std::memory_order_relaxed);
+}
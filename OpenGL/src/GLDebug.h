@@ -0,0 +1,43 @@
+#pragma once
+
+// KHR_debug (GL 4.3) message output. When active the driver reports errors
+// through a callback, so GLCall no longer has to poll glGetError after
+// every call. Without KHR_debug Init() fails and GLCall keeps polling.
+class GLDebug
+{
+public:
+	static const unsigned int MaxMessageLength = 512;
+	static const unsigned int Capacity = 256; // Power of two
+
+	struct Message
+	{
+		unsigned int Source;
+		unsigned int Type;
+		unsigned int ID;
+		unsigned int Severity;
+		char Text[MaxMessageLength];
+	};
+
+	// One row of the filter table, GL_DONT_CARE matches anything and ID 0 means every ID
+	struct Filter
+	{
+		unsigned int Source;
+		unsigned int Type;
+		unsigned int Severity;
+		unsigned int ID;
+		bool Enabled;
+	};
+
+	// Synchronous output calls back on the offending GL call, so high severity
+	// messages break right there. Asynchronous is faster but only gets logged.
+	static bool Init(bool synchronous);
+	static void Shutdown();
+	static bool IsActive();
+
+	static void SetSynchronous(bool synchronous);
+	static void ApplyFilter(const Filter& filter);
+
+	// Prints and removes queued messages, returns how many there were
+	static unsigned int Poll();
+	static unsigned int GetDroppedCount();
+};
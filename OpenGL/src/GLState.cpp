@@ -0,0 +1,259 @@
+#include "GLState.h"
+#include "Renderer.h"
+
+#include <unordered_map>
+
+namespace {
+
+    const unsigned int Unknown = 0xFFFFFFFF;
+
+    // Buffer targets whose binding is context state. GL_ELEMENT_ARRAY_BUFFER is
+    // vertex array state, so it is tracked per VAO instead.
+    const unsigned int BufferTargets[] = { GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_UNPACK_BUFFER };
+    const unsigned int BufferTargetCount = sizeof(BufferTargets) / sizeof(BufferTargets[0]);
+
+    const unsigned int TextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY };
+    const unsigned int TextureTargetCount = sizeof(TextureTargets) / sizeof(TextureTargets[0]);
+
+    struct State
+    {
+        unsigned int Program = Unknown;
+        unsigned int VertexArray = Unknown;
+        unsigned int Buffers[BufferTargetCount];
+        std::unordered_map<unsigned int, unsigned int> ElementBuffers; // VAO -> element buffer
+        unsigned int ActiveTexture = Unknown;
+        unsigned int Textures[GLState::MaxTextureUnits][TextureTargetCount];
+        int Blend = -1;
+        unsigned int BlendSrc = Unknown;
+        unsigned int BlendDst = Unknown;
+
+        State() { Reset(); }
+
+        void Reset()
+        {
+            Program = Unknown;
+            VertexArray = Unknown;
+            for (unsigned int i = 0; i < BufferTargetCount; i++)
+                Buffers[i] = Unknown;
+            ElementBuffers.clear();
+            ActiveTexture = Unknown;
+            for (unsigned int unit = 0; unit < GLState::MaxTextureUnits; unit++)
+                for (unsigned int i = 0; i < TextureTargetCount; i++)
+                    Textures[unit][i] = Unknown;
+            Blend = -1;
+            BlendSrc = Unknown;
+            BlendDst = Unknown;
+        }
+    };
+
+    State s_State;
+    GLState::Stats s_Stats;
+
+    int BufferTargetIndex(unsigned int target)
+    {
+        for (unsigned int i = 0; i < BufferTargetCount; i++)
+            if (BufferTargets[i] == target)
+                return i;
+        return -1;
+    }
+
+    int TextureTargetIndex(unsigned int target)
+    {
+        for (unsigned int i = 0; i < TextureTargetCount; i++)
+            if (TextureTargets[i] == target)
+                return i;
+        return -1;
+    }
+
+    // Returns true if the call has to be issued, and updates the cached value
+    bool Changed(unsigned int& cached, unsigned int value)
+    {
+        if (cached == value)
+        {
+            s_Stats.Skipped++;
+            return false;
+        }
+        cached = value;
+        s_Stats.Issued++;
+        return true;
+    }
+
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+    if (Changed(s_State.Program, program))
+    {
+        GLCall(glUseProgram(program));
+    }
+}
+
+void GLState::BindVertexArray(unsigned int vao)
+{
+    if (Changed(s_State.VertexArray, vao))
+    {
+        GLCall(glBindVertexArray(vao));
+    }
+}
+
+void GLState::BindBuffer(unsigned int target, unsigned int buffer)
+{
+    if (target == GL_ELEMENT_ARRAY_BUFFER && s_State.VertexArray != Unknown)
+    {
+        auto it = s_State.ElementBuffers.find(s_State.VertexArray);
+        unsigned int cached = it != s_State.ElementBuffers.end() ? it->second : Unknown;
+        if (Changed(cached, buffer))
+        {
+            GLCall(glBindBuffer(target, buffer));
+            s_State.ElementBuffers[s_State.VertexArray] = buffer;
+        }
+        return;
+    }
+
+    int index = BufferTargetIndex(target);
+    if (index < 0)
+    {
+        // Untracked target, always issue
+        s_Stats.Issued++;
+        GLCall(glBindBuffer(target, buffer));
+        return;
+    }
+
+    if (Changed(s_State.Buffers[index], buffer))
+    {
+        GLCall(glBindBuffer(target, buffer));
+    }
+}
+
+void GLState::ActiveTexture(unsigned int unit)
+{
+    if (Changed(s_State.ActiveTexture, unit))
+    {
+        GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+}
+
+void GLState::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    int index = TextureTargetIndex(target);
+    if (index < 0 || unit >= MaxTextureUnits)
+    {
+        ActiveTexture(unit);
+        s_Stats.Issued++;
+        GLCall(glBindTexture(target, texture));
+        return;
+    }
+
+    // Only switch the active unit when the binding on it actually changes
+    if (s_State.Textures[unit][index] == texture)
+    {
+        s_Stats.Skipped++;
+        return;
+    }
+
+    ActiveTexture(unit);
+    s_State.Textures[unit][index] = texture;
+    s_Stats.Issued++;
+    GLCall(glBindTexture(target, texture));
+}
+
+void GLState::SetBlend(bool enabled)
+{
+    if (s_State.Blend == (int)enabled)
+    {
+        s_Stats.Skipped++;
+        return;
+    }
+
+    s_State.Blend = (int)enabled;
+    s_Stats.Issued++;
+    if (enabled)
+    {
+        GLCall(glEnable(GL_BLEND));
+    }
+    else
+    {
+        GLCall(glDisable(GL_BLEND));
+    }
+}
+
+bool GLState::IsBlendEnabled()
+{
+    if (s_State.Blend == -1)
+    {
+        GLCall(s_State.Blend = glIsEnabled(GL_BLEND) ? 1 : 0);
+    }
+    return s_State.Blend == 1;
+}
+
+void GLState::BlendFunc(unsigned int src, unsigned int dst)
+{
+    if (s_State.BlendSrc == src && s_State.BlendDst == dst)
+    {
+        s_Stats.Skipped++;
+        return;
+    }
+
+    s_State.BlendSrc = src;
+    s_State.BlendDst = dst;
+    s_Stats.Issued++;
+    GLCall(glBlendFunc(src, dst));
+}
+
+unsigned int GLState::GetActiveTexture()
+{
+    return s_State.ActiveTexture != Unknown ? s_State.ActiveTexture : 0;
+}
+
+void GLState::OnProgramDeleted(unsigned int program)
+{
+    // A deleted program stays in use until another one is bound, but its name can't be trusted
+    if (s_State.Program == program)
+        s_State.Program = Unknown;
+}
+
+void GLState::OnVertexArrayDeleted(unsigned int vao)
+{
+    if (s_State.VertexArray == vao)
+        s_State.VertexArray = 0;
+    s_State.ElementBuffers.erase(vao);
+}
+
+void GLState::OnBufferDeleted(unsigned int buffer)
+{
+    for (unsigned int i = 0; i < BufferTargetCount; i++)
+        if (s_State.Buffers[i] == buffer)
+            s_State.Buffers[i] = 0;
+
+    // Other VAOs keep referencing the buffer, the name may be reused so forget it
+    for (auto it = s_State.ElementBuffers.begin(); it != s_State.ElementBuffers.end();)
+    {
+        if (it->second == buffer)
+            it = s_State.ElementBuffers.erase(it);
+        else
+            ++it;
+    }
+}
+
+void GLState::OnTextureDeleted(unsigned int texture)
+{
+    for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+        for (unsigned int i = 0; i < TextureTargetCount; i++)
+            if (s_State.Textures[unit][i] == texture)
+                s_State.Textures[unit][i] = 0;
+}
+
+void GLState::Invalidate()
+{
+    s_State.Reset();
+}
+
+const GLState::Stats& GLState::GetStats()
+{
+    return s_Stats;
+}
+
+void GLState::ResetStats()
+{
+    s_Stats = Stats();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Mirrors the GL binding state so redundant binds never reach the driver.
+// Every Bind()/Unbind() goes through here; anything that changes GL state
+// behind its back (ImGui, raw gl calls) must call Invalidate() afterwards.
+class GLState
+{
+public:
+	static const unsigned int MaxTextureUnits = 32;
+
+	struct Stats
+	{
+		unsigned int Issued = 0;
+		unsigned int Skipped = 0;
+	};
+
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vao);
+	static void BindBuffer(unsigned int target, unsigned int buffer);
+	static void ActiveTexture(unsigned int unit);
+	static void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+	static void SetBlend(bool enabled);
+	static void BlendFunc(unsigned int src, unsigned int dst);
+
+	static unsigned int GetActiveTexture();
+	static bool IsBlendEnabled(); // Asks GL once if the cache doesn't know
+
+	// GL unbinds deleted objects, call these after glDelete* so the cache agrees
+	static void OnProgramDeleted(unsigned int program);
+	static void OnVertexArrayDeleted(unsigned int vao);
+	static void OnBufferDeleted(unsigned int buffer);
+	static void OnTextureDeleted(unsigned int texture);
+
+	// Forget everything, the next call of each kind is always issued
+	static void Invalidate();
+
+	static const Stats& GetStats();
+	static void ResetStats();
+};
@@ -0,0 +1,161 @@
+#include "GPUMemory.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    struct Allocation
+    {
+        GPUMemoryCategory Category;
+        size_t Bytes;
+        unsigned int RendererID;
+        std::string Label;
+    };
+
+    std::unordered_map<const void*, Allocation> s_Allocations;
+    GPUMemory::Stats s_Categories[GPUMemoryCategoryCount];
+    GPUMemory::Stats s_Total;
+    size_t s_Budget = 0;
+    bool s_WarnedOverBudget = false;
+
+    void Add(GPUMemory::Stats& stats, size_t bytes)
+    {
+        stats.Bytes += bytes;
+        stats.Count++;
+        stats.PeakBytes = std::max(stats.PeakBytes, stats.Bytes);
+    }
+
+    void Remove(GPUMemory::Stats& stats, size_t bytes)
+    {
+        stats.Bytes -= bytes;
+        stats.Count--;
+    }
+
+    double ToMegabytes(size_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+}
+
+const char* GPUMemory::GetCategoryName(GPUMemoryCategory category)
+{
+    static const char* s_Names[GPUMemoryCategoryCount] = { "Vertex buffer", "Index buffer", "Uniform buffer", "Pixel buffer", "Texture", "Vertex array" };
+    return s_Names[(int)category];
+}
+
+void GPUMemory::Allocate(const void* owner, GPUMemoryCategory category, size_t bytes, unsigned int rendererID, const std::string& label)
+{
+    Free(owner);
+
+    s_Allocations[owner] = { category, bytes, rendererID, label };
+    Add(s_Categories[(int)category], bytes);
+    Add(s_Total, bytes);
+
+    if (s_Budget && s_Total.Bytes > s_Budget)
+    {
+        if (!s_WarnedOverBudget)
+        {
+            std::cout << "Warning: GPU memory over budget, " << std::fixed << std::setprecision(1) << ToMegabytes(s_Total.Bytes) <<
+                " of " << ToMegabytes(s_Budget) << " MB after " << GetCategoryName(category) << " " << rendererID << (label.empty() ? "" : " ") << label << std::endl;
+            s_WarnedOverBudget = true;
+        }
+    }
+    else
+    {
+        s_WarnedOverBudget = false;
+    }
+}
+
+void GPUMemory::Free(const void* owner)
+{
+    auto found = s_Allocations.find(owner);
+    if (found == s_Allocations.end())
+        return;
+
+    Remove(s_Categories[(int)found->second.Category], found->second.Bytes);
+    Remove(s_Total, found->second.Bytes);
+    s_Allocations.erase(found);
+
+    if (!s_Budget || s_Total.Bytes <= s_Budget)
+        s_WarnedOverBudget = false;
+}
+
+const GPUMemory::Stats& GPUMemory::GetStats(GPUMemoryCategory category)
+{
+    return s_Categories[(int)category];
+}
+
+const GPUMemory::Stats& GPUMemory::GetTotal()
+{
+    return s_Total;
+}
+
+void GPUMemory::ResetPeaks()
+{
+    for (Stats& stats : s_Categories)
+        stats.PeakBytes = stats.Bytes;
+    s_Total.PeakBytes = s_Total.Bytes;
+}
+
+void GPUMemory::SetBudget(size_t bytes)
+{
+    s_Budget = bytes;
+    s_WarnedOverBudget = false;
+}
+
+size_t GPUMemory::GetBudget()
+{
+    return s_Budget;
+}
+
+bool GPUMemory::IsOverBudget()
+{
+    return s_Budget && s_Total.Bytes > s_Budget;
+}
+
+void GPUMemory::Report(unsigned int maxAllocations)
+{
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::cout << "GPU memory: " << ToMegabytes(s_Total.Bytes) << " MB in " << s_Total.Count << " objects, peak " <<
+        ToMegabytes(s_Total.PeakBytes) << " MB" << std::endl;
+    for (int i = 0; i < GPUMemoryCategoryCount; i++)
+    {
+        const Stats& stats = s_Categories[i];
+        if (stats.Count == 0 && stats.PeakBytes == 0)
+            continue;
+        std::cout << "  " << std::left << std::setw(16) << GetCategoryName((GPUMemoryCategory)i) << std::right << std::setw(10) <<
+            ToMegabytes(stats.Bytes) << " MB  " << std::setw(5) << stats.Count << " objects, peak " << ToMegabytes(stats.PeakBytes) << " MB" << std::endl;
+    }
+
+    // Largest first, ties by category so the order is stable between reports
+    std::vector<const Allocation*> sorted;
+    sorted.reserve(s_Allocations.size());
+    for (const auto& entry : s_Allocations)
+        sorted.push_back(&entry.second);
+    std::sort(sorted.begin(), sorted.end(), [](const Allocation* a, const Allocation* b)
+    {
+        if (a->Bytes != b->Bytes)
+            return a->Bytes > b->Bytes;
+        if (a->Category != b->Category)
+            return a->Category < b->Category;
+        return a->RendererID < b->RendererID;
+    });
+
+    for (size_t i = 0; i < sorted.size() && i < maxAllocations; i++)
+    {
+        const Allocation& allocation = *sorted[i];
+        std::cout << "  " << std::setw(10) << ToMegabytes(allocation.Bytes) << " MB  " << GetCategoryName(allocation.Category) << " " <<
+            allocation.RendererID << (allocation.Label.empty() ? "" : " ") << allocation.Label << std::endl;
+    }
+    if (sorted.size() > maxAllocations)
+        std::cout << "  ... " << sorted.size() - maxAllocations << " more" << std::endl;
+
+    std::cout.flags(flags);
+}
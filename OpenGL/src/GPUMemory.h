@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+enum class GPUMemoryCategory
+{
+	VertexBuffer, IndexBuffer, UniformBuffer, PixelBuffer, Texture, VertexArray
+};
+const int GPUMemoryCategoryCount = 6;
+
+// Accounts for every buffer and texture the wrappers create, keyed by the owning
+// object. Sizes are what was asked for, the driver may pad or compress. Vertex
+// arrays own no storage, they're tracked at 0 bytes so leaks still show up.
+class GPUMemory
+{
+public:
+	struct Stats
+	{
+		size_t Bytes = 0;
+		size_t PeakBytes = 0; // High-water mark since the last ResetPeaks()
+		unsigned int Count = 0;
+	};
+
+	// Allocating again for the same owner replaces its previous size, for reallocations
+	static void Allocate(const void* owner, GPUMemoryCategory category, size_t bytes, unsigned int rendererID, const std::string& label = "");
+	static void Free(const void* owner);
+
+	static const Stats& GetStats(GPUMemoryCategory category);
+	static const Stats& GetTotal();
+	static void ResetPeaks();
+
+	// Warns once each time the total goes over, 0 turns it off
+	static void SetBudget(size_t bytes);
+	static size_t GetBudget();
+	static bool IsOverBudget();
+
+	// Totals per category, then the largest allocations. Anything printed after
+	// every owner is gone is a leak.
+	static void Report(unsigned int maxAllocations = 20);
+
+	static const char* GetCategoryName(GPUMemoryCategory category);
+};
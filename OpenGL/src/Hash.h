@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a. Pass the previous result as hash to continue over several buffers.
+const uint64_t Fnv1a64Offset = 14695981039346656037ull;
+
+inline uint64_t Fnv1a64(const void* data, size_t size, uint64_t hash = Fnv1a64Offset)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -1,5 +1,7 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "GPUMemory.h"
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
     : m_Count(count)
@@ -7,23 +9,26 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
     GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    GPUMemory::Allocate(this, GPUMemoryCategory::IndexBuffer, count * sizeof(unsigned int), m_RendererID);
 
     // Shouldn't we unbind?
 }
 
 IndexBuffer::~IndexBuffer()
 {
+    GPUMemory::Free(this);
     GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 }
 
 void IndexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
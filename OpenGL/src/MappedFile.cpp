@@ -0,0 +1,97 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filepath)
+    : m_Data(nullptr), m_Size(0), m_Open(false), m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr)
+{
+    m_File = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_File, &size))
+        return;
+    m_Size = (size_t)size.QuadPart;
+    m_Open = true;
+
+    // Mapping an empty file fails, there's nothing to point at anyway
+    if (m_Size == 0)
+        return;
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_Mapping)
+        m_Data = (const char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!m_Data)
+    {
+        m_Size = 0;
+        m_Open = false;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE)
+        CloseHandle(m_File);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filepath)
+    : m_Data(nullptr), m_Size(0), m_Open(false)
+{
+    int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0)
+    {
+        m_Size = (size_t)info.st_size;
+        m_Open = true;
+
+        // Mapping an empty file fails, there's nothing to point at anyway
+        if (m_Size > 0)
+        {
+            void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                m_Size = 0;
+                m_Open = false;
+            }
+            else
+            {
+                m_Data = (const char*)data;
+                madvise(data, m_Size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+
+    // The mapping keeps the file alive on its own
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data)
+        munmap((void*)m_Data, m_Size);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into memory, so parsers can point
+// into it instead of copying. The view lives as long as the object.
+class MappedFile
+{
+private:
+	const char* m_Data;
+	size_t m_Size;
+	bool m_Open;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#endif
+
+public:
+	MappedFile(const std::string& filepath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// An empty file is open with no data
+	inline bool IsOpen() const { return m_Open; }
+	inline const char* GetData() const { return m_Data; }
+	inline size_t GetSize() const { return m_Size; }
+};
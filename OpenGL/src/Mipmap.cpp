@@ -0,0 +1,172 @@
+#include "Mipmap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    const float Pi = 3.14159265358979f;
+
+    // Kaiser window parameters, radius is in destination pixels
+    const float KaiserRadius = 3.0f;
+    const float KaiserAlpha = 4.0f;
+
+    struct Image
+    {
+        int Width, Height;
+        std::vector<float> Texels; // Linear, premultiplied RGBA
+    };
+
+    float SrgbToLinear(float c)
+    {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float c)
+    {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // Zeroth order modified Bessel function of the first kind, the series converges quickly
+    float BesselI0(float x)
+    {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+            if (term < sum * 1e-7f)
+                break;
+        }
+        return sum;
+    }
+
+    float Weight(MipFilter filter, float x)
+    {
+        x = std::fabs(x);
+        if (filter == MipFilter::Box)
+            return x <= 0.5f ? 1.0f : 0.0f;
+
+        if (x >= KaiserRadius)
+            return 0.0f;
+        float sinc = x < 1e-5f ? 1.0f : std::sin(Pi * x) / (Pi * x);
+        float t = x / KaiserRadius;
+        return sinc * BesselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(KaiserAlpha);
+    }
+
+    float Radius(MipFilter filter)
+    {
+        return filter == MipFilter::Box ? 0.5f : KaiserRadius;
+    }
+
+    // Shrinks one axis from 'size' to 'newSize' texels. 'stride' steps along the
+    // axis, 'lines'/'lineStride' walk the other one. Edges clamp like GL_CLAMP_TO_EDGE.
+    void Resample(const float* source, float* destination, int size, int newSize,
+        int stride, int lines, int lineStride, MipFilter filter)
+    {
+        float scale = (float)size / newSize;
+        float reach = Radius(filter) * scale;
+        std::vector<float> weights;
+
+        for (int i = 0; i < newSize; i++)
+        {
+            float center = (i + 0.5f) * scale;
+            int first = (int)std::floor(center - reach);
+            int last = (int)std::ceil(center + reach);
+
+            weights.clear();
+            float total = 0.0f;
+            for (int s = first; s <= last; s++)
+            {
+                float w = Weight(filter, (s + 0.5f - center) / scale);
+                weights.push_back(w);
+                total += w;
+            }
+
+            for (int line = 0; line < lines; line++)
+            {
+                float sum[4] = {};
+                for (int s = first; s <= last; s++)
+                {
+                    float w = weights[s - first];
+                    if (w == 0.0f)
+                        continue;
+                    int clamped = std::min(std::max(s, 0), size - 1);
+                    const float* texel = source + line * lineStride + clamped * stride;
+                    for (int c = 0; c < 4; c++)
+                        sum[c] += texel[c] * w;
+                }
+
+                float* texel = destination + line * lineStride + i * stride;
+                for (int c = 0; c < 4; c++)
+                    texel[c] = sum[c] / total;
+            }
+        }
+    }
+
+    Image Downsample(const Image& source, MipFilter filter)
+    {
+        int width = std::max(source.Width / 2, 1);
+        int height = std::max(source.Height / 2, 1);
+
+        // Separable, horizontal into a temporary then vertical
+        std::vector<float> horizontal((size_t)width * source.Height * 4);
+        Resample(source.Texels.data(), horizontal.data(), source.Width, width, 4, source.Height, width * 4, filter);
+
+        Image result = { width, height, std::vector<float>((size_t)width * height * 4) };
+        Resample(horizontal.data(), result.Texels.data(), source.Height, height, width * 4, width, 4, filter);
+        return result;
+    }
+
+    MipLevel Quantize(const Image& image)
+    {
+        MipLevel level = { image.Width, image.Height, std::vector<unsigned char>(image.Texels.size()) };
+        for (size_t i = 0; i < image.Texels.size(); i += 4)
+        {
+            // Sinc lobes can overshoot, clamp before undoing the premultiply
+            float alpha = std::min(std::max(image.Texels[i + 3], 0.0f), 1.0f);
+            for (int c = 0; c < 3; c++)
+            {
+                float value = alpha > 0.0f ? image.Texels[i + c] / alpha : 0.0f;
+                value = LinearToSrgb(std::min(std::max(value, 0.0f), 1.0f));
+                level.Pixels[i + c] = (unsigned char)(value * 255.0f + 0.5f);
+            }
+            level.Pixels[i + 3] = (unsigned char)(alpha * 255.0f + 0.5f);
+        }
+        return level;
+    }
+
+}
+
+int MipLevelCount(int width, int height)
+{
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+        levels++;
+    return levels;
+}
+
+std::vector<MipLevel> GenerateMipChain(const unsigned char* pixels, int width, int height, MipFilter filter)
+{
+    float toLinear[256];
+    for (int i = 0; i < 256; i++)
+        toLinear[i] = SrgbToLinear(i / 255.0f);
+
+    Image image = { width, height, std::vector<float>((size_t)width * height * 4) };
+    for (size_t i = 0; i < image.Texels.size(); i += 4)
+    {
+        float alpha = pixels[i + 3] / 255.0f;
+        for (int c = 0; c < 3; c++)
+            image.Texels[i + c] = toLinear[pixels[i + c]] * alpha;
+        image.Texels[i + 3] = alpha;
+    }
+
+    // Each level comes from the previous one in float, so rounding never accumulates
+    std::vector<MipLevel> levels;
+    while (image.Width > 1 || image.Height > 1)
+    {
+        image = Downsample(image, filter);
+        levels.push_back(Quantize(image));
+    }
+    return levels;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+// CPU side mip chain generation, for offline baking or when the driver's
+// glGenerateMipmap box filter isn't good enough. Filtering happens in linear
+// light on premultiplied alpha, so transparent edges don't darken or bleed.
+enum class MipFilter
+{
+	Box,   // Averages each 2x2 footprint like most drivers, but in linear light
+	Kaiser // Kaiser windowed sinc, sharper minification with little ringing
+};
+
+struct MipLevel
+{
+	int Width, Height;
+	std::vector<unsigned char> Pixels; // RGBA8
+};
+
+// Levels in a full chain down to 1x1, including level 0
+int MipLevelCount(int width, int height);
+
+// Builds levels 1 and up from an RGBA8 level 0
+std::vector<MipLevel> GenerateMipChain(const unsigned char* pixels, int width, int height, MipFilter filter);
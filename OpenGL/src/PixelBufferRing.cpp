@@ -0,0 +1,132 @@
+#include "PixelBufferRing.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Buffer offsets handed to glTexSubImage2D have to be aligned to the pixel size, be generous
+static const size_t s_SlotAlignment = 256;
+
+PixelBufferRing::PixelBufferRing(size_t slotSize, unsigned int slotCount)
+    : m_RendererID(0), m_SlotSize((slotSize + s_SlotAlignment - 1) & ~(s_SlotAlignment - 1)),
+      m_Mapped(nullptr), m_Fences(slotCount, nullptr), m_Next(0)
+{
+    size_t size = m_SlotSize * slotCount;
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID);
+
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+    {
+        // Coherent, so writes through the pointer are visible without a flush
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags));
+        GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    }
+    else
+    {
+        GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+    }
+
+    GPUMemory::Allocate(this, GPUMemoryCategory::PixelBuffer, size, m_RendererID, "upload ring");
+
+    // Anything else using glTexImage2D with a client pointer needs this unbound
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+PixelBufferRing::~PixelBufferRing()
+{
+    GPUMemory::Free(this);
+    for (void* fence : m_Fences)
+    {
+        if (fence)
+        {
+            GLCall(glDeleteSync((GLsync)fence));
+        }
+    }
+
+    if (m_Mapped)
+    {
+        GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID);
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+    }
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
+}
+
+void PixelBufferRing::WaitForSlot(unsigned int slot)
+{
+    GLsync fence = (GLsync)m_Fences[slot];
+    if (!fence)
+        return;
+
+    // Already done is the common case, only count real waits
+    GLCall(GLenum result = glClientWaitSync(fence, 0, 0));
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        m_Stats.Stalls++;
+        do
+        {
+            GLCall(result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000)); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    GLCall(glDeleteSync(fence));
+    m_Fences[slot] = nullptr;
+}
+
+void PixelBufferRing::Upload(const Texture& texture, int x, int y, int width, int height, const unsigned char* pixels, int level)
+{
+    size_t rowSize = (size_t)width * 4;
+    int bandHeight = (int)(m_SlotSize / rowSize);
+    if (bandHeight == 0)
+    {
+        m_Stats.Fallbacks++;
+        texture.SetSubImage(x, y, width, height, pixels, level);
+        return;
+    }
+
+    // Rows are contiguous, so a band is a single copy. The bands fill the ring in order,
+    // an image larger than the whole ring waits for its own first bands to finish.
+    for (int row = 0; row < height; row += bandHeight)
+    {
+        int rows = std::min(bandHeight, height - row);
+        UploadBand(texture, x, y + row, width, rows, pixels + row * rowSize, level);
+    }
+    m_Stats.Uploads++;
+}
+
+void PixelBufferRing::UploadBand(const Texture& texture, int x, int y, int width, int height, const unsigned char* pixels, int level)
+{
+    size_t size = (size_t)width * height * 4;
+
+    unsigned int slot = m_Next;
+    m_Next = (m_Next + 1) % m_Fences.size();
+    WaitForSlot(slot);
+
+    size_t offset = slot * m_SlotSize;
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID);
+
+    if (m_Mapped)
+    {
+        memcpy(m_Mapped + offset, pixels, size);
+    }
+    else
+    {
+        // The fence already guarantees the GPU is done with this range
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        GLCall(void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size, flags));
+        memcpy(mapped, pixels, size);
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+    }
+
+    // With a pixel unpack buffer bound the pointer is an offset into it
+    texture.SetSubImage(x, y, width, height, (const void*)(uintptr_t)offset, level);
+    GLCall(m_Fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_Stats.Bands++;
+}
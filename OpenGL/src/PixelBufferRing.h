@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class Texture;
+
+// Streams texture uploads through a ring of pixel unpack buffer slots. Pixels are
+// memcpy'd into GPU-visible memory and glTexSubImage2D reads from there, so the
+// call returns without the driver copying out of client memory first. Each slot
+// gets a fence and is only written again once the GPU is done reading it.
+// With ARB_buffer_storage the buffer stays persistently mapped, otherwise each
+// slot is mapped unsynchronized for the copy and unmapped before the upload.
+// Images bigger than a slot go up in bands of rows, one slot per band.
+class PixelBufferRing
+{
+public:
+	struct Stats
+	{
+		unsigned int Uploads = 0;
+		unsigned int Stalls = 0;    // Had to wait for the GPU to free a slot
+		unsigned int Bands = 0;     // Slots used, more than Uploads when images were split
+		unsigned int Fallbacks = 0; // A single row is bigger than a slot, uploaded from client memory
+	};
+
+private:
+	unsigned int m_RendererID;
+	size_t m_SlotSize;
+	unsigned char* m_Mapped; // Persistent mapping of the whole ring, null when mapping per upload
+	std::vector<void*> m_Fences; // GLsync per slot, null when the slot is free
+	unsigned int m_Next;
+	Stats m_Stats;
+
+public:
+	// The default fits one 1024x1024 RGBA8 image per slot
+	PixelBufferRing(size_t slotSize = 1024 * 1024 * 4, unsigned int slotCount = 3);
+	~PixelBufferRing();
+
+	PixelBufferRing(const PixelBufferRing&) = delete;
+	PixelBufferRing& operator=(const PixelBufferRing&) = delete;
+
+	// Copies RGBA8 pixels into the next slot, or several for large images, and starts the
+	// upload into the texture's level. The texture must already have storage covering the rectangle.
+	void Upload(const Texture& texture, int x, int y, int width, int height, const unsigned char* pixels, int level = 0);
+
+	inline bool IsPersistent() const { return m_Mapped != nullptr; }
+	inline size_t GetSlotSize() const { return m_SlotSize; }
+	inline const Stats& GetStats() const { return m_Stats; }
+
+private:
+	void WaitForSlot(unsigned int slot);
+	void UploadBand(const Texture& texture, int x, int y, int width, int height, const unsigned char* pixels, int level);
+};
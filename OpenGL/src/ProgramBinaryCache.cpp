@@ -0,0 +1,148 @@
+#include "ProgramBinaryCache.h"
+#include "Renderer.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static std::string s_Directory;
+
+// File layout: header, then Length bytes of driver binary
+struct ProgramBinaryHeader
+{
+    char Magic[4];
+    uint32_t Format;
+    uint32_t Length;
+};
+
+static const char s_Magic[4] = { 'G', 'L', 'P', 'B' };
+
+static bool IsSupported()
+{
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+        return false;
+
+    int formats = 0;
+    GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+    return formats > 0;
+}
+
+static std::string GetPath(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return s_Directory + "/" + name;
+}
+
+void ProgramBinaryCache::SetDirectory(const std::string& directory)
+{
+    s_Directory = directory;
+
+    if (!s_Directory.empty() && !IsSupported())
+    {
+        std::cout << "ProgramBinaryCache: program binaries not supported, compiling from source" << std::endl;
+        s_Directory.clear();
+    }
+}
+
+bool ProgramBinaryCache::IsEnabled()
+{
+    return !s_Directory.empty();
+}
+
+uint64_t ProgramBinaryCache::HashSeed()
+{
+    // A binary is only valid for the driver that produced it
+    uint64_t hash = Fnv1a64Offset;
+    const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (GLenum name : strings)
+    {
+        const char* value = (const char*)glGetString(name);
+        if (value)
+            hash = Fnv1a64(value, strlen(value), hash);
+    }
+    return hash;
+}
+
+uint64_t ProgramBinaryCache::HashSource(const std::string& source, uint64_t seed)
+{
+    // Include the terminator so stage boundaries can't shift between files
+    return Fnv1a64(source.c_str(), source.size() + 1, seed);
+}
+
+uint64_t ProgramBinaryCache::HashSource(const char* data, size_t size, uint64_t seed)
+{
+    return Fnv1a64(data, size, seed);
+}
+
+unsigned int ProgramBinaryCache::Load(uint64_t key)
+{
+    if (!IsEnabled())
+        return 0;
+
+    std::ifstream stream(GetPath(key), std::ios::binary);
+    if (!stream)
+        return 0;
+
+    ProgramBinaryHeader header;
+    if (!stream.read((char*)&header, sizeof(header)) || memcmp(header.Magic, s_Magic, sizeof(s_Magic)) != 0)
+        return 0;
+
+    std::vector<char> binary(header.Length);
+    if (!stream.read(binary.data(), header.Length))
+        return 0;
+
+    GLCall(unsigned int program = glCreateProgram());
+    GLCall(glProgramBinary(program, header.Format, binary.data(), header.Length));
+
+    // The driver may reject binaries from older versions of itself, fall back to source
+    int status;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    if (status == GL_FALSE)
+    {
+        GLCall(glDeleteProgram(program));
+        return 0;
+    }
+
+    return program;
+}
+
+void ProgramBinaryCache::PrepareProgram(unsigned int program)
+{
+    if (IsEnabled())
+    {
+        GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+}
+
+void ProgramBinaryCache::Save(uint64_t key, unsigned int program)
+{
+    if (!IsEnabled())
+        return;
+
+    int length = 0;
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    std::ofstream stream(GetPath(key), std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "ProgramBinaryCache: can't write " << GetPath(key) << std::endl;
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    memcpy(header.Magic, s_Magic, sizeof(s_Magic));
+    header.Format = format;
+    header.Length = (uint32_t)length;
+    stream.write((const char*)&header, sizeof(header));
+    stream.write(binary.data(), length);
+}
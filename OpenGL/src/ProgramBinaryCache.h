@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Stores linked program binaries on disk (glGetProgramBinary) keyed by a hash
+// of the shader sources and the GL vendor, renderer and version strings, so a
+// driver update or different GPU never gets handed a stale binary.
+class ProgramBinaryCache
+{
+public:
+	// Empty disables the cache. The directory has to exist.
+	static void SetDirectory(const std::string& directory);
+	static bool IsEnabled();
+
+	// Key for the given sources, combine several stages by passing the previous key as seed
+	static uint64_t HashSource(const std::string& source, uint64_t seed);
+	// Raw bytes with no terminator, consecutive calls hash the same as one call over the concatenation
+	static uint64_t HashSource(const char* data, size_t size, uint64_t seed);
+	static uint64_t HashSeed();
+
+	// Returns a linked program, or 0 if there is no entry or the driver rejected it
+	static unsigned int Load(uint64_t key);
+	// Call before glLinkProgram so the driver keeps the binary around
+	static void PrepareProgram(unsigned int program);
+	static void Save(uint64_t key, unsigned int program);
+};
@@ -1,13 +1,25 @@
 #include "Renderer.h"
+#include "GLDebug.h"
+#include "GLState.h"
+#include "Texture.h"
 #include <iostream>
 
+// With KHR_debug output active the driver reports errors itself, so the
+// polling below is skipped to avoid a glGetError round trip per call
+
 void GLClearError()
 {
+    if (GLDebug::IsActive())
+        return;
+
     while (glGetError() != GL_NO_ERROR);
 }
 
 bool GLLogCall(const char* function, const char* file, int line)
 {
+    if (GLDebug::IsActive())
+        return true;
+
     while (GLenum error = glGetError()) // while error is not 0
     {
         std::cout << "[OpenGL Error] (" << error << "): " <<
@@ -19,6 +31,122 @@ bool GLLogCall(const char* function, const char* file, int line)
     return true;
 }
 
+// Last place errors were checked, errors found later were raised somewhere after it
+static const char* s_LastCheckedCall = "start";
+static unsigned int s_CallsSinceCheck = 0;
+
+static bool GLReportErrors(const char* function, const char* file, int line)
+{
+    bool ok = true;
+    while (GLenum error = glGetError())
+    {
+        std::cout << "[OpenGL Error] (" << error << "): after " <<
+            s_LastCheckedCall << ", by " <<
+            function;
+        if (line)
+            std::cout << " " << file << ":" << line;
+        std::cout << std::endl;
+        ok = false;
+    }
+
+    s_LastCheckedCall = function;
+    s_CallsSinceCheck = 0;
+    return ok;
+}
+
+bool GLCountCall(const char* function, const char* file, int line)
+{
+    if (++s_CallsSinceCheck < GL_ERROR_CHECK_INTERVAL || GLDebug::IsActive())
+        return true;
+
+    return GLReportErrors(function, file, line);
+}
+
+bool GLCheckErrors(const char* context)
+{
+#if GL_ERROR_CHECK == 0
+    (void)context;
+    return true;
+#else
+    if (GLDebug::IsActive())
+        return GLDebug::Poll() == 0;
+
+    return GLReportErrors(context, "", 0);
+#endif
+}
+
+// Room for a few hundred camera or material blocks a frame
+static const size_t UniformRegionSize = 64 * 1024;
+static const size_t VertexRegionSize = 4 * 1024 * 1024;
+
+Renderer::Renderer()
+    : m_Camera{ glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f) }, m_UniformAlignment(1)
+{
+    if (RingBuffer::IsSupported())
+    {
+        GLint alignment;
+        GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+        m_UniformAlignment = alignment;
+        m_UniformRing.reset(new RingBuffer(GL_UNIFORM_BUFFER, UniformRegionSize, 3));
+    }
+    else
+    {
+        m_CameraBuffer.reset(new UniformBuffer(sizeof(CameraData), CameraBinding));
+    }
+}
+
+void Renderer::SetCamera(const glm::mat4& projection, const glm::mat4& view)
+{
+    m_Camera = { projection, view, projection * view };
+    if (!m_UniformRing)
+    {
+        m_CameraBuffer->SetData(&m_Camera, sizeof(m_Camera));
+        return;
+    }
+
+    RingBuffer::Allocation allocation = m_UniformRing->Write(&m_Camera, sizeof(m_Camera), m_UniformAlignment);
+    m_UniformRing->BindRange(CameraBinding, allocation);
+}
+
+RingBuffer::Allocation Renderer::AllocateTransientVertices(size_t size, size_t stride)
+{
+    if (!RingBuffer::IsSupported())
+        return { nullptr, 0, 0 };
+
+    if (!m_VertexRing)
+        m_VertexRing.reset(new RingBuffer(GL_ARRAY_BUFFER, VertexRegionSize, 3));
+    return m_VertexRing->Allocate(size, stride);
+}
+
+RingBuffer::Allocation Renderer::AllocateTransientUniforms(size_t size)
+{
+    if (!m_UniformRing)
+        return { nullptr, 0, 0 };
+
+    return m_UniformRing->Allocate(size, m_UniformAlignment);
+}
+
+void Renderer::BindTransientUniforms(unsigned int binding, const RingBuffer::Allocation& allocation) const
+{
+    m_UniformRing->BindRange(binding, allocation);
+}
+
+void Renderer::EndFrame()
+{
+    if (m_VertexRing)
+        m_VertexRing->EndFrame();
+
+    if (m_UniformRing)
+    {
+        m_UniformRing->EndFrame();
+
+        // The bound camera block is in the region just fenced and gets overwritten once the
+        // ring comes around, carry it over for callers that only set the camera on change
+        RingBuffer::Allocation allocation = m_UniformRing->Write(&m_Camera, sizeof(m_Camera), m_UniformAlignment);
+        m_UniformRing->BindRange(CameraBinding, allocation);
+    }
+}
+
 void Renderer::Clear() const
 {
     GLCall(glClear(GL_COLOR_BUFFER_BIT));
@@ -33,3 +161,141 @@ void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader&
 
     GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
 }
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const
+{
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr, instanceCount));
+}
+
+static constexpr UniformHandle s_ModelUniform("u_Model");
+static constexpr UniformHandle s_ColorUniform("u_Color");
+
+// Sort key layout, most significant first:
+//   layer (8) | translucent (1) | opaque:      shader (12) | texture (12) | vao (12) | depth (19)
+//                               | translucent: far-to-near depth (19) | shader (12) | texture (12) | vao (12)
+// Opaque draws group by state and go front to back within a material,
+// translucent draws must keep back to front order for blending so depth comes first.
+static const unsigned int DepthBits = 19;
+static const uint64_t DepthMax = (1ull << DepthBits) - 1;
+static const uint64_t IDMask = 0xFFF;
+
+uint64_t Renderer::MakeSortKey(unsigned int layer, bool translucent, unsigned int shaderID,
+    unsigned int textureID, unsigned int vaoID, float depth)
+{
+    if (depth < 0.0f) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    uint64_t quantizedDepth = (uint64_t)(depth * DepthMax);
+
+    uint64_t key = (uint64_t)(layer & 0xFF) << 56;
+    if (translucent)
+    {
+        key |= 1ull << 55;
+        key |= (DepthMax - quantizedDepth) << 36;
+        key |= (shaderID & IDMask) << 24;
+        key |= (textureID & IDMask) << 12;
+        key |= (vaoID & IDMask);
+    }
+    else
+    {
+        key |= (shaderID & IDMask) << 43;
+        key |= (textureID & IDMask) << 31;
+        key |= (vaoID & IDMask) << 19;
+        key |= quantizedDepth;
+    }
+    return key;
+}
+
+void Renderer::BeginScene()
+{
+    m_Queue.clear();
+}
+
+void Renderer::Submit(const VertexArray& va, const IndexBuffer& ib, Shader& shader, const Texture& texture,
+    const glm::mat4& transform, const glm::vec4& color, unsigned int layer, bool translucent, float depth)
+{
+    uint64_t key = MakeSortKey(layer, translucent, shader.GetRendererID(), texture.GetRendererID(), va.GetRendererID(), depth);
+    m_Queue.push_back({ key, &va, &ib, &shader, &texture, transform, color });
+    m_QueueStats.Submitted++;
+}
+
+void Renderer::EndScene()
+{
+    SortQueue();
+
+    // Opaque draws skip blending, whatever was set before comes back afterwards
+    bool blend = GLState::IsBlendEnabled();
+
+    const std::vector<uint32_t>& order = m_SortIndices[0];
+    for (uint32_t index : order)
+    {
+        const RenderCommand& command = m_Queue[index];
+
+        GLState::SetBlend((command.SortKey & (1ull << 55)) != 0);
+
+        command.Program->Bind();
+        command.Program->SetUniformMat4f(s_ModelUniform, command.Transform);
+        command.Program->SetUniform4f(s_ColorUniform, command.Color);
+        command.Tex->Bind(0);
+        command.Vao->Bind();
+        command.Ibo->Bind();
+
+        GLCall(glDrawElements(GL_TRIANGLES, command.Ibo->GetCount(), GL_UNSIGNED_INT, nullptr));
+        m_QueueStats.DrawCalls++;
+    }
+
+    GLState::SetBlend(blend);
+    m_Queue.clear();
+}
+
+void Renderer::ResetQueueStats()
+{
+    m_QueueStats = QueueStats();
+}
+
+// LSD radix sort of the queue indices by key, 8 bits per pass.
+// Passes where every key has the same byte are skipped, which is most of
+// them since layer and the upper id bits rarely vary.
+void Renderer::SortQueue()
+{
+    const size_t count = m_Queue.size();
+    m_SortKeys.resize(count);
+    m_SortIndices[0].resize(count);
+    m_SortIndices[1].resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        m_SortKeys[i] = m_Queue[i].SortKey;
+        m_SortIndices[0][i] = (uint32_t)i;
+    }
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = {};
+        for (size_t i = 0; i < count; i++)
+            histogram[(m_SortKeys[i] >> shift) & 0xFF]++;
+
+        if (histogram[(m_SortKeys.empty() ? 0 : (m_SortKeys[0] >> shift) & 0xFF)] == count)
+            continue;
+
+        size_t offset = 0;
+        for (size_t& bucket : histogram)
+        {
+            size_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        const std::vector<uint32_t>& source = m_SortIndices[0];
+        std::vector<uint32_t>& destination = m_SortIndices[1];
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t index = source[i];
+            destination[histogram[(m_SortKeys[index] >> shift) & 0xFF]++] = index;
+        }
+        m_SortIndices[0].swap(m_SortIndices[1]);
+    }
+}
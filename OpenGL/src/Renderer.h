@@ -2,27 +2,151 @@
 
 #include <GL/glew.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "UniformBuffer.h"
+#include "RingBuffer.h"
+
+
+// GL error checking level, define GL_ERROR_CHECK in the project to override
+//   0 - GLCall compiles down to the bare call (default in Release)
+//   1 - errors are polled every GL_ERROR_CHECK_INTERVAL calls and by GLCheckErrors()
+//   2 - every call is checked (default in Debug)
+#ifndef GL_ERROR_CHECK
+    #ifdef NDEBUG
+        #define GL_ERROR_CHECK 0
+    #else
+        #define GL_ERROR_CHECK 2
+    #endif
+#endif
 
+#ifndef GL_ERROR_CHECK_INTERVAL
+    #define GL_ERROR_CHECK_INTERVAL 256
+#endif
 
-#define ASSERT(x) if (!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
-    x;\
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#if defined(_MSC_VER)
+    #define DEBUG_BREAK() __debugbreak()
+#elif defined(__GNUC__) || defined(__clang__)
+    #define DEBUG_BREAK() __builtin_trap()
+#else
+    #include <cstdlib>
+    #define DEBUG_BREAK() std::abort()
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK();
+
+#if GL_ERROR_CHECK >= 2
+    #define GLCall(x) GLClearError();\
+        x;\
+        ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#elif GL_ERROR_CHECK == 1
+    #define GLCall(x) x;\
+        ASSERT(GLCountCall(#x, __FILE__, __LINE__))
+#else
+    #define GLCall(x) x
+#endif
 
 
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
+bool GLCountCall(const char* function, const char* file, int line);
+
+// Drains pending errors (or KHR_debug messages), call once per frame.
+// Does nothing when GL_ERROR_CHECK is 0.
+bool GLCheckErrors(const char* context);
 
 
+class Texture;
+
+// A deferred draw, executed in SortKey order by Renderer::EndScene
+struct RenderCommand
+{
+    uint64_t SortKey;
+    const VertexArray* Vao;
+    const IndexBuffer* Ibo;
+    Shader* Program;
+    const Texture* Tex;
+    glm::mat4 Transform;
+    glm::vec4 Color;
+};
+
+// Layout of the std140 "Camera" uniform block shared by all shaders
+struct CameraData
+{
+    glm::mat4 Projection;
+    glm::mat4 View;
+    glm::mat4 ViewProjection;
+};
+
 class Renderer
 {
+public:
+    // Uniform block binding points
+    static const unsigned int CameraBinding = 0;
+    static const unsigned int TextureHandleBinding = 1; // Bindless handles, see BatchRenderer
+
+    struct QueueStats
+    {
+        unsigned int Submitted = 0;
+        unsigned int DrawCalls = 0;
+    };
+
 private:
-        
+    std::vector<RenderCommand> m_Queue;
+    std::vector<uint64_t> m_SortKeys;
+    std::vector<uint32_t> m_SortIndices[2];
+    CameraData m_Camera;
+    std::unique_ptr<UniformBuffer> m_CameraBuffer; // Only without RingBuffer support
+    std::unique_ptr<RingBuffer> m_UniformRing;     // Camera blocks and transient uniforms
+    std::unique_ptr<RingBuffer> m_VertexRing;      // Transient vertices, made on first use
+    size_t m_UniformAlignment;
+    QueueStats m_QueueStats;
 
 public:
+    Renderer();
+
     void Clear() const;
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+    void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const;
+
+    // Writes the camera block once, every shader bound to CameraBinding sees it. With a ring
+    // each call takes fresh memory, so draws already issued keep the camera they were given.
+    void SetCamera(const glm::mat4& projection, const glm::mat4& view);
+
+    // Scratch memory for data rebuilt every frame, written straight into a persistently mapped
+    // RingBuffer. It stays valid until EndFrame, Data is null without RingBuffer support or for
+    // more than a region, callers fall back to a Stream VertexBuffer or a UniformBuffer then.
+    // Vertices are stride aligned so Offset / stride is the base vertex, the buffer to attach
+    // with VertexArray::AddBuffer is GetTransientVertexBuffer().
+    RingBuffer::Allocation AllocateTransientVertices(size_t size, size_t stride);
+    RingBuffer::Allocation AllocateTransientUniforms(size_t size);
+    void BindTransientUniforms(unsigned int binding, const RingBuffer::Allocation& allocation) const;
+    inline const RingBuffer* GetTransientVertexBuffer() const { return m_VertexRing.get(); }
+
+    // Fences this frame's transient memory, call once after the frame's last draw
+    void EndFrame();
+
+    // Deferred path: draws are queued, sorted to minimize state changes and run on EndScene.
+    // Queued shaders get u_Model and u_Color set per draw, texture binds to slot 0.
+    // Depth is in [0, 1] with 0 nearest, translucent draws within a layer run back to front.
+    void BeginScene();
+    void Submit(const VertexArray& va, const IndexBuffer& ib, Shader& shader, const Texture& texture,
+        const glm::mat4& transform, const glm::vec4& color = glm::vec4(0.0f),
+        unsigned int layer = 0, bool translucent = false, float depth = 0.0f);
+    void EndScene();
+
+    // Counts accumulate until reset, reset once per frame
+    inline const QueueStats& GetQueueStats() const { return m_QueueStats; }
+    void ResetQueueStats();
+
+    static uint64_t MakeSortKey(unsigned int layer, bool translucent, unsigned int shaderID,
+        unsigned int textureID, unsigned int vaoID, float depth);
+
+private:
+    void SortQueue();
 };
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "RingBuffer.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+
+#include <cstring>
+
+RingBuffer::RingBuffer(unsigned int target, size_t regionSize, unsigned int regionCount)
+    : m_RendererID(0), m_Target(target), m_RegionSize(regionSize), m_Mapped(nullptr),
+      m_Fences(regionCount, nullptr), m_Region(0), m_Offset(0)
+{
+    ASSERT(IsSupported());
+
+    size_t size = m_RegionSize * regionCount;
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLState::BindBuffer(m_Target, m_RendererID);
+
+    // Coherent, so writes through the pointer are visible to the next draw without a flush
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLCall(glBufferStorage(m_Target, size, nullptr, flags));
+    GLCall(m_Mapped = (unsigned char*)glMapBufferRange(m_Target, 0, size, flags));
+
+    GPUMemoryCategory category = m_Target == GL_UNIFORM_BUFFER ? GPUMemoryCategory::UniformBuffer : GPUMemoryCategory::VertexBuffer;
+    GPUMemory::Allocate(this, category, size, m_RendererID, "ring");
+}
+
+RingBuffer::~RingBuffer()
+{
+    GPUMemory::Free(this);
+    for (void* fence : m_Fences)
+    {
+        if (fence)
+        {
+            GLCall(glDeleteSync((GLsync)fence));
+        }
+    }
+
+    GLState::BindBuffer(m_Target, m_RendererID);
+    GLCall(glUnmapBuffer(m_Target));
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
+}
+
+bool RingBuffer::IsSupported()
+{
+    return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+void RingBuffer::WaitForRegion(unsigned int region)
+{
+    GLsync fence = (GLsync)m_Fences[region];
+    if (!fence)
+        return;
+
+    // Already done is the common case, only count real waits
+    GLCall(GLenum result = glClientWaitSync(fence, 0, 0));
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        m_Stats.Stalls++;
+        do
+        {
+            GLCall(result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000)); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    GLCall(glDeleteSync(fence));
+    m_Fences[region] = nullptr;
+}
+
+void RingBuffer::NextRegion()
+{
+    // An untouched region has nothing in flight, it can stay current
+    if (m_Offset == 0)
+        return;
+
+    GLCall(m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    m_Region = (m_Region + 1) % m_Fences.size();
+    m_Offset = 0;
+    WaitForRegion(m_Region);
+}
+
+RingBuffer::Allocation RingBuffer::Allocate(size_t size, size_t alignment)
+{
+    if (size > m_RegionSize)
+    {
+        m_Stats.Overflows++;
+        return { nullptr, 0, 0 };
+    }
+
+    // Aligned from the start of the buffer, region starts aren't multiples of every stride
+    size_t regionStart = m_Region * m_RegionSize;
+    size_t offset = (regionStart + m_Offset + alignment - 1) / alignment * alignment;
+    if (offset + size > regionStart + m_RegionSize)
+    {
+        NextRegion();
+        regionStart = m_Region * m_RegionSize;
+        offset = (regionStart + alignment - 1) / alignment * alignment;
+        if (offset + size > regionStart + m_RegionSize)
+        {
+            m_Stats.Overflows++;
+            return { nullptr, 0, 0 };
+        }
+    }
+
+    m_Offset = offset + size - regionStart;
+    m_Stats.Allocations++;
+    return { m_Mapped + offset, offset, size };
+}
+
+RingBuffer::Allocation RingBuffer::Write(const void* data, size_t size, size_t alignment)
+{
+    Allocation allocation = Allocate(size, alignment);
+    if (allocation.Data)
+        memcpy(allocation.Data, data, size);
+    return allocation;
+}
+
+void RingBuffer::EndFrame()
+{
+    NextRegion();
+}
+
+void RingBuffer::Bind() const
+{
+    GLState::BindBuffer(m_Target, m_RendererID);
+}
+
+void RingBuffer::Unbind() const
+{
+    GLState::BindBuffer(m_Target, 0);
+}
+
+void RingBuffer::BindRange(unsigned int binding, const Allocation& allocation) const
+{
+    // Also binds the generic target, keep the cache in step
+    Bind();
+    GLCall(glBindBufferRange(m_Target, binding, m_RendererID, allocation.Offset, allocation.Size));
+}
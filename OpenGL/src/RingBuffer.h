@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Persistently mapped buffer for data that's rebuilt every frame, split into regions
+// that are handed out with a bump pointer. Writes go straight into GPU-visible memory
+// with no glBufferData or glBufferSubData, so there's neither a driver copy nor an
+// implicit sync. Each region gets a fence when it's left and is only reused once the
+// GPU is done reading it, so with three regions the CPU can run two frames ahead.
+// Needs GL 4.4 or ARB_buffer_storage, see IsSupported().
+class RingBuffer
+{
+public:
+	struct Allocation
+	{
+		void* Data;    // Write here, null if the request didn't fit a region
+		size_t Offset; // From the start of the buffer, for attribute offsets and glBindBufferRange
+		size_t Size;
+	};
+
+	struct Stats
+	{
+		unsigned int Allocations = 0;
+		unsigned int Stalls = 0;    // Had to wait for the GPU to finish with a region
+		unsigned int Overflows = 0; // Bigger than a region, nothing was allocated
+	};
+
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Target;
+	size_t m_RegionSize;
+	unsigned char* m_Mapped;
+	std::vector<void*> m_Fences; // GLsync per region, null when the region is free
+	unsigned int m_Region;
+	size_t m_Offset; // Bump pointer inside the current region
+	Stats m_Stats;
+
+public:
+	RingBuffer(unsigned int target, size_t regionSize, unsigned int regionCount = 3);
+	~RingBuffer();
+
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	static bool IsSupported();
+
+	// The offset is a multiple of 'alignment' from the start of the buffer, which needn't be
+	// a power of two: pass the vertex stride to draw with a base vertex. Moves on to the next
+	// region when the current one is full, draws using it must already be issued.
+	Allocation Allocate(size_t size, size_t alignment = 16);
+	// Copies into a fresh allocation
+	Allocation Write(const void* data, size_t size, size_t alignment = 16);
+
+	// Fences the region in use and moves to the next one, call after the frame's last draw
+	void EndFrame();
+
+	void Bind() const;
+	void Unbind() const;
+	// For uniform or shader storage buffers, the allocation's offset must respect
+	// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	void BindRange(unsigned int binding, const Allocation& allocation) const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline size_t GetRegionSize() const { return m_RegionSize; }
+	inline const Stats& GetStats() const { return m_Stats; }
+
+private:
+	void NextRegion();
+	void WaitForRegion(unsigned int region);
+};
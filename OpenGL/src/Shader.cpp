@@ -1,165 +1,787 @@
 #include "Shader.h"
 #include "GL/glew.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "ProgramBinaryCache.h"
+#include "Hash.h"
+#include "VertexBufferLayout.h"
 
-#include <sstream>
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
-Shader::Shader(const std::string& filepath)
-    :m_FilePath(filepath), m_RendererID(0)
+// Indexed by ShaderType
+static const unsigned int s_StageTypes[ShaderTypeCount] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER };
+static const char* const s_StageNames[ShaderTypeCount] = { "vertex", "fragment", "geometry", "compute" };
+
+static const char* StageName(unsigned int type)
+{
+    for (int i = 0; i < ShaderTypeCount; i++)
+        if (s_StageTypes[i] == type)
+            return s_StageNames[i];
+    return "unknown";
+}
+
+Shader::Shader(const std::string& filepath, bool async)
+    :Shader(filepath, std::vector<std::string>(), async)
+{
+}
+
+Shader::Shader(const std::string& filepath, const std::vector<std::string>& defines, bool async)
+    :m_FilePath(filepath), m_Defines(defines), m_RendererID(0), m_Pending(false), m_CacheKey(0)
 {
     ShaderProgramSource source = ParseShader(filepath);
-    m_RendererID = CreateShader(source.VertexShaderSource, source.FragmentShaderSource);
+    m_Files = source.Files;
+    m_RendererID = CreateShader(source);
+
+    if (!async)
+        FinishProgram();
 }
 
 Shader::~Shader()
 {
+    // Still compiling stages have to be cleaned up too
+    for (const PendingStage& stage : m_PendingStages)
+    {
+        GLCall(glDeleteShader(stage.ID));
+    }
     GLCall(glDeleteProgram(m_RendererID));
+    GLState::OnProgramDeleted(m_RendererID);
 }
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+// True if the line starts with 'directive' after any leading whitespace
+static bool IsDirective(const char* line, const char* end, const char* directive)
+{
+    while (line < end && (*line == ' ' || *line == '\t'))
+        line++;
+    size_t length = strlen(directive);
+    return (size_t)(end - line) >= length && memcmp(line, directive, length) == 0;
+}
+
+static bool Contains(const char* line, const char* end, const char* word)
 {
-    // Open file
-    std::ifstream stream(filepath);
+    return std::search(line, end, word, word + strlen(word)) != end;
+}
 
-    // Define Type
-    enum class ShaderType
+// Returns the path between the quotes or angle brackets of an #include line
+static std::string IncludePath(const char* line, const char* end)
+{
+    const char* open = std::find_if(line, end, [](char c) { return c == '"' || c == '<'; });
+    if (open == end)
+        return "";
+    const char* close = std::find_if(open + 1, end, [](char c) { return c == '"' || c == '>'; });
+    if (close == end)
+        return "";
+    return std::string(open + 1, close);
+}
+
+static std::string Directory(const std::string& filepath)
+{
+    size_t slash = filepath.find_last_of("/\\");
+    return slash == std::string::npos ? "" : filepath.substr(0, slash + 1);
+}
+
+// Start of the next line, and the end of this one without its newline
+static const char* NextLine(const char* line, const char* end, const char*& lineEnd)
+{
+    lineEnd = (const char*)memchr(line, '\n', end - line);
+    if (!lineEnd)
+        return lineEnd = end;
+    return lineEnd + 1;
+}
+
+static void AppendGenerated(ShaderProgramSource& source, std::vector<ShaderSourceSpan>& stage, std::string text)
+{
+    source.Generated.push_back(std::move(text));
+    const std::string& stored = source.Generated.back();
+    stage.push_back({ stored.data(), (int)stored.size() });
+}
+
+// Consecutive lines of a file end up as one span
+static void AppendMapped(std::vector<ShaderSourceSpan>& stage, const char* begin, const char* end)
+{
+    if (begin == end)
+        return;
+
+    ShaderSourceSpan* last = stage.empty() ? nullptr : &stage.back();
+    if (last && last->Data + last->Length == begin)
+        last->Length += (int)(end - begin);
+    else
+        stage.push_back({ begin, (int)(end - begin) });
+}
+
+// Maps each file once per parse, index is its #line source string number
+static const MappedFile& MapSourceFile(ShaderProgramSource& source, const std::string& filepath, size_t& index)
+{
+    auto file = std::find(source.Files.begin(), source.Files.end(), filepath);
+    index = file - source.Files.begin();
+    if (file == source.Files.end())
     {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
-    ShaderType type = ShaderType::NONE;
+        source.Files.push_back(filepath);
+        source.Mappings.emplace_back(new MappedFile(filepath));
+    }
+    return *source.Mappings[index];
+}
+
+// Appends 'filepath' to the stage with its own #includes expanded. Every file is
+// included at most once per stage, so include guards aren't needed and cycles stop.
+static void ExpandInclude(ShaderProgramSource& source, const std::string& filepath,
+    std::vector<ShaderSourceSpan>& stage, std::vector<std::string>& included)
+{
+    if (std::find(included.begin(), included.end(), filepath) != included.end())
+        return;
+    included.push_back(filepath);
+
+    size_t fileIndex;
+    const MappedFile& file = MapSourceFile(source, filepath, fileIndex);
+    if (!file.IsOpen())
+    {
+        std::cout << "Failed to open shader include " << filepath << "!" << std::endl;
+        return;
+    }
+
+    // #line's second number is the source string, errors report it before the line number
+    AppendGenerated(source, stage, "#line 1 " + std::to_string(fileIndex) + "\n");
+
+    const char* end = file.GetData() + file.GetSize();
+    const char* lineEnd;
+    int lineNumber = 0;
+    for (const char* line = file.GetData(); line < end; )
+    {
+        const char* next = NextLine(line, end, lineEnd);
+        lineNumber++;
+
+        if (IsDirective(line, lineEnd, "#include"))
+        {
+            ExpandInclude(source, Directory(filepath) + IncludePath(line, lineEnd), stage, included);
+            AppendGenerated(source, stage, "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n");
+        }
+        else
+        {
+            AppendMapped(stage, line, next);
+        }
+        line = next;
+    }
+
+    // Whatever comes next has to start on its own line
+    if (file.GetSize() > 0 && end[-1] != '\n')
+        AppendGenerated(source, stage, "\n");
+}
 
-    // Line and string stream variables for parsing
-    std::string line;
-    std::stringstream ss[2];
+ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+{
+    ShaderProgramSource result;
 
-    // Parse file, if the line contains "#shader type" change the type
-    // Otherwise add the line to the correct string stream
-    while (getline(stream, line))
+    // Map the file, stage sources point straight into it
+    size_t fileIndex;
+    const MappedFile& file = MapSourceFile(result, filepath, fileIndex);
+    if (!file.IsOpen())
+        std::cout << "Failed to open shader " << filepath << "!" << std::endl;
+
+    std::string defines;
+    for (const std::string& define : m_Defines)
+    {
+        std::string text = define;
+        size_t equals = text.find('=');
+        if (equals != std::string::npos)
+            text[equals] = ' ';
+        defines += "#define " + text + "\n";
+    }
+
+    ShaderType type = ShaderType::NONE;
+    std::vector<std::string> included[ShaderTypeCount];
+    bool versioned[ShaderTypeCount] = {};
+
+    // Scan for "#shader type" markers and change the type, anything before the first one is dropped.
+    // #version lines get the defines after them, #include lines get the file pasted in
+    const char* end = file.GetData() + file.GetSize();
+    const char* lineEnd;
+    int lineNumber = 0;
+    for (const char* line = file.GetData(); line < end; )
     {
-        if (line.find("#shader") != std::string::npos)
+        const char* next = NextLine(line, end, lineEnd);
+        lineNumber++;
+
+        if (IsDirective(line, lineEnd, "#shader"))
         {
-            if (line.find("vertex") != std::string::npos)
+            if (Contains(line, lineEnd, "vertex"))
                 type = ShaderType::VERTEX;
-            else if (line.find("fragment") != std::string::npos)
+            else if (Contains(line, lineEnd, "fragment"))
                 type = ShaderType::FRAGMENT;
+            else if (Contains(line, lineEnd, "geometry"))
+                type = ShaderType::GEOMETRY;
+            else if (Contains(line, lineEnd, "compute"))
+                type = ShaderType::COMPUTE;
+            else
+                std::cout << "Unknown shader stage '" << std::string(line, lineEnd) << "' in " << filepath << std::endl;
         }
-        else
+        else if (type != ShaderType::NONE)
         {
             // Using the enum type as an index instead of branching
-            ss[(int)type] << line << '\n';
+            std::vector<ShaderSourceSpan>& stage = result.Sources[(int)type];
+
+            if (IsDirective(line, lineEnd, "#version"))
+            {
+                AppendMapped(stage, line, next);
+                if (next == end && lineEnd == end)
+                    AppendGenerated(result, stage, "\n");
+                AppendGenerated(result, stage, defines + "#line " + std::to_string(lineNumber + 1) + " 0\n");
+                versioned[(int)type] = true;
+            }
+            else if (IsDirective(line, lineEnd, "#include"))
+            {
+                ExpandInclude(result, Directory(filepath) + IncludePath(line, lineEnd), stage, included[(int)type]);
+                AppendGenerated(result, stage, "#line " + std::to_string(lineNumber + 1) + " 0\n");
+            }
+            else
+            {
+                AppendMapped(stage, line, next);
+            }
         }
+        line = next;
     }
 
-    // Return the struct using the string stream array
-    return { ss[0].str(), ss[1].str() };
-
+    // Without a #version line the defines just go first
+    for (int i = 0; i < ShaderTypeCount; i++)
+    {
+        std::vector<ShaderSourceSpan>& stage = result.Sources[i];
+        if (!versioned[i] && !stage.empty() && !defines.empty())
+        {
+            result.Generated.push_back(defines);
+            const std::string& stored = result.Generated.back();
+            stage.insert(stage.begin(), { stored.data(), (int)stored.size() });
+        }
+    }
+    return result;
 }
 
-unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
+unsigned int Shader::CompileShader(unsigned int type, const std::vector<ShaderSourceSpan>& source)
 {
     GLCall(unsigned int id = glCreateShader(type));
-    const char* src = source.c_str();
 
-    GLCall(glShaderSource(id, 1, &src, nullptr));
+    // The driver takes every span at once and copies them itself
+    std::vector<const char*> strings(source.size());
+    std::vector<int> lengths(source.size());
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        strings[i] = source[i].Data;
+        lengths[i] = source[i].Length;
+    }
+
+    GLCall(glShaderSource(id, (int)source.size(), strings.data(), lengths.data()));
     GLCall(glCompileShader(id));
 
-    // Error handling
-    int result;
-    GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
+    // Status is only checked in FinishProgram, so the driver can keep compiling in the background
+    m_PendingStages.push_back({ type, id });
+    return id;
+}
 
-    if (result == GL_FALSE)
+unsigned int Shader::CreateShader(const ShaderProgramSource& source)
+{
+    bool hasCompute = !source.Sources[(int)ShaderType::COMPUTE].empty();
+    if (hasCompute && !GLEW_VERSION_4_3 && !GLEW_ARB_compute_shader)
+        std::cout << "Warning: " << m_FilePath << " has a compute stage but compute shaders aren't supported!" << std::endl;
+
+    // Skip compiling entirely if this exact source was linked by this driver before
+    m_CacheKey = 0;
+    if (ProgramBinaryCache::IsEnabled())
     {
+        m_CacheKey = ProgramBinaryCache::HashSeed();
+        for (int i = 0; i < ShaderTypeCount; i++)
+        {
+            // Mix the stage in so moving code between stages changes the key
+            m_CacheKey = Fnv1a64(&i, sizeof(i), m_CacheKey);
+            for (const ShaderSourceSpan& span : source.Sources[i])
+                m_CacheKey = ProgramBinaryCache::HashSource(span.Data, span.Length, m_CacheKey);
+        }
+
+        if (unsigned int program = ProgramBinaryCache::Load(m_CacheKey))
+        {
+            // Already linked, FinishProgram only has to reflect it
+            m_Pending = true;
+            return program;
+        }
+    }
+
+    GLCall(unsigned int program = glCreateProgram());
+    for (int i = 0; i < ShaderTypeCount; i++)
+    {
+        if (source.Sources[i].empty())
+            continue;
+
+        // Compute programs can't have any other stage, and may not be supported at all
+        bool isCompute = i == (int)ShaderType::COMPUTE;
+        if (isCompute && (!GLEW_VERSION_4_3 && !GLEW_ARB_compute_shader))
+            continue;
+        if (!isCompute && hasCompute)
+        {
+            std::cout << "Warning: " << m_FilePath << " mixes compute with other stages, ignoring the " << s_StageNames[i] << " stage" << std::endl;
+            continue;
+        }
+
+        unsigned int id = CompileShader(s_StageTypes[i], source.Sources[i]);
+        GLCall(glAttachShader(program, id));
+    }
+    ProgramBinaryCache::PrepareProgram(program);
+    GLCall(glLinkProgram(program));
+
+    m_Pending = true;
+    return program;
+}
+
+bool Shader::FinishProgram() const
+{
+    if (!m_Pending)
+        return true;
+    m_Pending = false;
+
+    // First status query, blocks until the driver is done compiling and linking
+    int linked;
+    GLCall(glGetProgramiv(m_RendererID, GL_LINK_STATUS, &linked));
+
+    if (linked == GL_FALSE)
+    {
+        for (const PendingStage& stage : m_PendingStages)
+        {
+            int result;
+            GLCall(glGetShaderiv(stage.ID, GL_COMPILE_STATUS, &result));
+
+            if (result == GL_FALSE)
+            {
+                int length;
+                GLCall(glGetShaderiv(stage.ID, GL_INFO_LOG_LENGTH, &length));
+                char* message = (char*)alloca(length * sizeof(char));
+                GLCall(glGetShaderInfoLog(stage.ID, length, &length, message));
+
+                std::cout << "Failed to compile " << StageName(stage.Type) << " shader!" << std::endl;
+                std::cout << message << std::endl;
+            }
+        }
+
         int length;
-        GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
+        GLCall(glGetProgramiv(m_RendererID, GL_INFO_LOG_LENGTH, &length));
         char* message = (char*)alloca(length * sizeof(char));
-        GLCall(glGetShaderInfoLog(id, length, &length, message));
+        GLCall(glGetProgramInfoLog(m_RendererID, length, &length, message));
 
-        std::cout << "Failed to compile " <<
-            (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
-            << " shader!" << std::endl;
+        std::cout << "Failed to link " << m_FilePath << "!" << std::endl;
         std::cout << message << std::endl;
 
-        GLCall(glDeleteShader(id));
-        return 0;
+        // Errors are reported as "file(line)" where file is the #line source string
+        for (size_t i = 1; i < m_Files.size(); i++)
+            std::cout << "  source string " << i << " is " << m_Files[i] << std::endl;
     }
 
-    return id;
+    // We can delete the intermediates now that 'program' contains the shaders.
+    // Programs loaded from the binary cache never had any
+    bool compiled = !m_PendingStages.empty();
+    for (const PendingStage& stage : m_PendingStages)
+    {
+        GLCall(glDetachShader(m_RendererID, stage.ID));
+        GLCall(glDeleteShader(stage.ID));
+    }
+    m_PendingStages.clear();
+
+    if (linked == GL_FALSE)
+        return false;
+
+    if (compiled)
+        ProgramBinaryCache::Save(m_CacheKey, m_RendererID);
+
+    Reflect();
+    return true;
 }
 
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+void Shader::Reflect() const
 {
-    GLCall(unsigned int program = glCreateProgram());
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    m_Uniforms.clear();
+    m_Attributes.clear();
+    m_UniformBlocks.clear();
+    m_UniformLocationCache.clear();
 
-    GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
-    GLCall(glLinkProgram(program));
-    GLCall(glValidateProgram(program));
+    int count = 0, maxLength = 0;
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    std::vector<char> name(maxLength + 1);
 
-    // We can delete the intermediates now that 'program' contains the shaders
-    GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
+    for (int i = 0; i < count; i++)
+    {
+        ShaderUniform uniform;
+        GLCall(glGetActiveUniform(m_RendererID, i, maxLength + 1, nullptr, &uniform.Size, &uniform.Type, name.data()));
 
-    return program;
+        unsigned int index = i;
+        GLCall(glGetActiveUniformsiv(m_RendererID, 1, &index, GL_UNIFORM_BLOCK_INDEX, &uniform.BlockIndex));
+
+        // Arrays are reported as "name[0]", both spellings find the first element
+        std::string reported = name.data();
+        size_t bracket = reported.find('[');
+        uniform.Name = reported.substr(0, bracket);
+        uniform.Location = -1;
+
+        if (uniform.BlockIndex == -1)
+        {
+            GLCall(uniform.Location = glGetUniformLocation(m_RendererID, reported.c_str()));
+            m_UniformLocationCache.push_back({ HashUniformName(uniform.Name.c_str()), uniform.Location, uniform.Name });
+            if (bracket != std::string::npos)
+                m_UniformLocationCache.push_back({ HashUniformName(reported.c_str()), uniform.Location, reported });
+        }
+        m_Uniforms.push_back(uniform);
+    }
+
+    std::sort(m_UniformLocationCache.begin(), m_UniformLocationCache.end(),
+        [](const UniformSlot& a, const UniformSlot& b) { return a.Hash < b.Hash; });
+#ifndef NDEBUG
+    for (size_t i = 1; i < m_UniformLocationCache.size(); i++)
+        if (m_UniformLocationCache[i - 1].Hash == m_UniformLocationCache[i].Hash)
+            std::cout << "Warning: uniforms '" << m_UniformLocationCache[i - 1].Name << "' and '" << m_UniformLocationCache[i].Name << "' have the same hash!" << std::endl;
+#endif
+
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_ATTRIBUTES, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength));
+    name.resize(maxLength + 1);
+
+    for (int i = 0; i < count; i++)
+    {
+        ShaderAttribute attribute;
+        GLCall(glGetActiveAttrib(m_RendererID, i, maxLength + 1, nullptr, &attribute.Size, &attribute.Type, name.data()));
+        attribute.Name = name.data();
+        GLCall(attribute.Location = glGetAttribLocation(m_RendererID, name.data()));
+
+        // Built-ins like gl_VertexID have no location
+        if (attribute.Location != -1)
+            m_Attributes.push_back(attribute);
+    }
+
+    std::sort(m_Attributes.begin(), m_Attributes.end(),
+        [](const ShaderAttribute& a, const ShaderAttribute& b) { return a.Location < b.Location; });
+
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_BLOCKS, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength));
+    name.resize(maxLength + 1);
+
+    for (int i = 0; i < count; i++)
+    {
+        ShaderUniformBlock block;
+        block.Index = i;
+        GLCall(glGetActiveUniformBlockName(m_RendererID, i, maxLength + 1, nullptr, name.data()));
+        GLCall(glGetActiveUniformBlockiv(m_RendererID, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.DataSize));
+        GLCall(glGetActiveUniformBlockiv(m_RendererID, i, GL_UNIFORM_BLOCK_BINDING, &block.Binding));
+        block.Name = name.data();
+        m_UniformBlocks.push_back(block);
+    }
 }
 
+const std::vector<ShaderUniform>& Shader::GetUniforms() const
+{
+    FinishProgram();
+    return m_Uniforms;
+}
 
+const std::vector<ShaderAttribute>& Shader::GetAttributes() const
+{
+    FinishProgram();
+    return m_Attributes;
+}
 
+const std::vector<ShaderUniformBlock>& Shader::GetUniformBlocks() const
+{
+    FinishProgram();
+    return m_UniformBlocks;
+}
 
+const ShaderAttribute* Shader::FindAttribute(const std::string& name) const
+{
+    for (const ShaderAttribute& attribute : GetAttributes())
+        if (attribute.Name == name)
+            return &attribute;
+    return nullptr;
+}
 
+// How many locations an attribute of this type takes and how many components each reads
+static void AttributeShape(unsigned int type, unsigned int& locations, unsigned int& components, bool& integer)
+{
+    locations = 1;
+    integer = false;
+    switch (type)
+    {
+        case GL_FLOAT:              components = 1; break;
+        case GL_FLOAT_VEC2:         components = 2; break;
+        case GL_FLOAT_VEC3:         components = 3; break;
+        case GL_FLOAT_VEC4:         components = 4; break;
+        case GL_FLOAT_MAT2:         components = 2; locations = 2; break;
+        case GL_FLOAT_MAT3:         components = 3; locations = 3; break;
+        case GL_FLOAT_MAT4:         components = 4; locations = 4; break;
+        case GL_INT:
+        case GL_UNSIGNED_INT:       components = 1; integer = true; break;
+        case GL_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC2:  components = 2; integer = true; break;
+        case GL_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC3:  components = 3; integer = true; break;
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT_VEC4:  components = 4; integer = true; break;
+        default:                    components = 4; break;
+    }
+}
+
+bool Shader::ValidateLayout(const VertexBufferLayout& layout, unsigned int firstLocation) const
+{
+    // Split the layout into locations the same way VertexArray::AddBuffer does
+    std::vector<unsigned int> provided;
+    for (const VertexBufferElement& element : layout.GetElements())
+        for (unsigned int column = 0; column < element.count; column += 4)
+            provided.push_back(element.count - column < 4 ? element.count - column : 4);
+
+    unsigned int lastLocation = firstLocation + (unsigned int)provided.size();
+    std::vector<bool> used(provided.size(), false);
+    bool valid = true;
+
+    for (const ShaderAttribute& attribute : GetAttributes())
+    {
+        unsigned int location = (unsigned int)attribute.Location;
+        if (location < firstLocation || location >= lastLocation)
+            continue;
+
+        unsigned int locations, components;
+        bool integer;
+        AttributeShape(attribute.Type, locations, components, integer);
+        locations *= attribute.Size;
+
+        // VertexArray only uses glVertexAttribPointer, integer inputs would read converted floats
+        if (integer)
+        {
+            std::cout << "Layout error in " << m_FilePath << ": '" << attribute.Name << "' is an integer input, the buffer feeds it floats" << std::endl;
+            valid = false;
+        }
+
+        if (location + locations > lastLocation)
+        {
+            std::cout << "Layout error in " << m_FilePath << ": '" << attribute.Name << "' needs locations " <<
+                location << "-" << location + locations - 1 << " but the layout ends at " << lastLocation - 1 << std::endl;
+            valid = false;
+            locations = lastLocation - location;
+        }
+
+        for (unsigned int i = 0; i < locations; i++)
+        {
+            unsigned int slot = location - firstLocation + i;
+            used[slot] = true;
+
+            // Missing components are filled with (0, 0, 0, 1), which is how vec4 positions take 2 floats
+            if (provided[slot] > components)
+                std::cout << "Layout warning in " << m_FilePath << ": location " << location + i << " ('" << attribute.Name <<
+                    "') gets " << provided[slot] << " components but reads " << components << std::endl;
+        }
+    }
+
+    for (size_t i = 0; i < used.size(); i++)
+        if (!used[i])
+            std::cout << "Layout warning in " << m_FilePath << ": location " << firstLocation + i << " is fetched but never read" << std::endl;
+
+    return valid;
+}
+
+// Copies the current value of every active default-block uniform and every
+// block binding from one program to another with the same names
+static void CopyProgramState(unsigned int from, unsigned int to)
+{
+    // glUniform* writes to the bound program, glProgramUniform* would need GL 4.1
+    GLState::UseProgram(to);
+
+    int count = 0, maxLength = 0;
+    GLCall(glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(from, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    std::vector<char> name(maxLength + 16);
+
+    for (int i = 0; i < count; i++)
+    {
+        int size;
+        GLenum type;
+        GLCall(glGetActiveUniform(from, i, maxLength, nullptr, &size, &type, name.data()));
+
+        // Array uniforms are reported as "name[0]", copy each element
+        char* bracket = strchr(name.data(), '[');
+        if (bracket)
+            *bracket = '\0';
+        std::string base = name.data();
+
+        for (int element = 0; element < size; element++)
+        {
+            std::string elementName = bracket ? base + "[" + std::to_string(element) + "]" : base;
+            GLCall(int source = glGetUniformLocation(from, elementName.c_str()));
+            GLCall(int destination = glGetUniformLocation(to, elementName.c_str()));
+            if (source == -1 || destination == -1)
+                continue;
+
+            // Block members have no location and were skipped above
+            float f[16];
+            int n[4];
+            switch (type)
+            {
+                case GL_FLOAT:      GLCall(glGetUniformfv(from, source, f)); GLCall(glUniform1fv(destination, 1, f)); break;
+                case GL_FLOAT_VEC2: GLCall(glGetUniformfv(from, source, f)); GLCall(glUniform2fv(destination, 1, f)); break;
+                case GL_FLOAT_VEC3: GLCall(glGetUniformfv(from, source, f)); GLCall(glUniform3fv(destination, 1, f)); break;
+                case GL_FLOAT_VEC4: GLCall(glGetUniformfv(from, source, f)); GLCall(glUniform4fv(destination, 1, f)); break;
+                case GL_FLOAT_MAT3: GLCall(glGetUniformfv(from, source, f)); GLCall(glUniformMatrix3fv(destination, 1, GL_FALSE, f)); break;
+                case GL_FLOAT_MAT4: GLCall(glGetUniformfv(from, source, f)); GLCall(glUniformMatrix4fv(destination, 1, GL_FALSE, f)); break;
+                case GL_INT:
+                case GL_BOOL:
+                case GL_SAMPLER_2D:
+                case GL_SAMPLER_2D_ARRAY:
+                    GLCall(glGetUniformiv(from, source, n)); GLCall(glUniform1iv(destination, 1, n)); break;
+                default:
+                    std::cout << "Warning: can't carry uniform '" << elementName << "' over on reload" << std::endl;
+                    break;
+            }
+        }
+    }
+
+    int blocks = 0;
+    GLCall(glGetProgramiv(from, GL_ACTIVE_UNIFORM_BLOCKS, &blocks));
+    for (int i = 0; i < blocks; i++)
+    {
+        int binding, length;
+        GLCall(glGetActiveUniformBlockiv(from, i, GL_UNIFORM_BLOCK_BINDING, &binding));
+        GLCall(glGetActiveUniformBlockiv(from, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &length));
+        std::vector<char> blockName(length + 1);
+        GLCall(glGetActiveUniformBlockName(from, i, length + 1, nullptr, blockName.data()));
+
+        GLCall(unsigned int index = glGetUniformBlockIndex(to, blockName.data()));
+        if (index != GL_INVALID_INDEX)
+        {
+            GLCall(glUniformBlockBinding(to, index, binding));
+        }
+    }
+}
+
+bool Shader::Reload()
+{
+    // Finish the current program first so the pending state belongs to the new one
+    FinishProgram();
+
+    unsigned int previous = m_RendererID;
+    ShaderProgramSource source = ParseShader(m_FilePath);
+    m_Files = source.Files;
+    m_RendererID = CreateShader(source);
+
+    if (!FinishProgram())
+    {
+        std::cout << "Reload of " << m_FilePath << " failed, keeping the previous program" << std::endl;
+        GLCall(glDeleteProgram(m_RendererID));
+        m_RendererID = previous;
+        return false;
+    }
+
+    CopyProgramState(previous, m_RendererID);
+
+    // Swap, FinishProgram already reflected the new program's locations
+    GLCall(glDeleteProgram(previous));
+    GLState::OnProgramDeleted(previous);
+
+    std::cout << "Reloaded " << m_FilePath << std::endl;
+    return true;
+}
+
+bool Shader::IsReady() const
+{
+    if (!m_Pending)
+        return true;
+
+    // Without KHR_parallel_shader_compile there is no way to ask without blocking
+    if (!GLEW_KHR_parallel_shader_compile)
+        return true;
+
+    int completed;
+    GLCall(glGetProgramiv(m_RendererID, GL_COMPLETION_STATUS_KHR, &completed));
+    return completed != GL_FALSE;
+}
+
+void Shader::EnableParallelCompile()
+{
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        // Let the driver pick how many of its threads to use
+        GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+    }
+}
 
 void Shader::Bind() const
 {
-    GLCall(glUseProgram(m_RendererID));
+    FinishProgram();
+    GLState::UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const
 {
-    GLCall(glUseProgram(0));
+    GLState::UseProgram(0);
 }
 
-void Shader::SetUniform1i(const std::string& name, int value)
+void Shader::SetUniform1i(const UniformHandle& uniform, int value)
 {
-    GLCall(glUniform1i(GetUniformLocation(name), value));
+    GLCall(glUniform1i(GetUniformLocation(uniform), value));
 }
 
-void Shader::SetUniform1f(const std::string& name, float value)
+void Shader::SetUniform1iv(const UniformHandle& uniform, int count, const int* values)
 {
-    GLCall(glUniform1f(GetUniformLocation(name), value));
+    GLCall(glUniform1iv(GetUniformLocation(uniform), count, values));
 }
 
-void Shader::SetUniform4f(const std::string& name, float f0, float f1, float f2, float f3)
+void Shader::SetUniform1f(const UniformHandle& uniform, float value)
 {
-    GLCall(glUniform4f(GetUniformLocation(name), f0, f1, f2, f3));
+    GLCall(glUniform1f(GetUniformLocation(uniform), value));
 }
 
-void Shader::SetUniform4f(const std::string& name, const glm::vec4& v)
+void Shader::SetUniform4f(const UniformHandle& uniform, float f0, float f1, float f2, float f3)
 {
-    GLCall(glUniform4f(GetUniformLocation(name), v.x, v.y, v.z, v.w));
+    GLCall(glUniform4f(GetUniformLocation(uniform), f0, f1, f2, f3));
 }
 
-void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
+void Shader::SetUniform4f(const UniformHandle& uniform, const glm::vec4& v)
 {
-    GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+    GLCall(glUniform4f(GetUniformLocation(uniform), v.x, v.y, v.z, v.w));
 }
 
+void Shader::SetUniformMat4f(const UniformHandle& uniform, const glm::mat4& matrix)
+{
+    GLCall(glUniformMatrix4fv(GetUniformLocation(uniform), 1, GL_FALSE, &matrix[0][0]));
+}
+
+
+
+void Shader::SetUniformBlockBinding(const std::string& blockName, unsigned int binding)
+{
+    FinishProgram();
+
+    GLCall(unsigned int index = glGetUniformBlockIndex(m_RendererID, blockName.c_str()));
 
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cout << "Warning: uniform block '" << blockName << "' doesn't exist!" << std::endl;
+        return;
+    }
+
+    GLCall(glUniformBlockBinding(m_RendererID, index, binding));
+}
 
-int Shader::GetUniformLocation(const std::string& name)
+int Shader::GetUniformLocation(const UniformHandle& uniform)
 {
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
+    FinishProgram();
+
+    auto it = std::lower_bound(m_UniformLocationCache.begin(), m_UniformLocationCache.end(), uniform.Hash,
+        [](const UniformSlot& slot, uint32_t hash) { return slot.Hash < hash; });
+
+    if (it != m_UniformLocationCache.end() && it->Hash == uniform.Hash)
     {
-        return m_UniformLocationCache[name];
+#ifndef NDEBUG
+        if (strcmp(it->Name.c_str(), uniform.Name) != 0)
+            std::cout << "Warning: uniforms '" << it->Name << "' and '" << uniform.Name << "' have the same hash!" << std::endl;
+#endif
+        return it->Location;
     }
 
-    GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+    GLCall(int location = glGetUniformLocation(m_RendererID, uniform.Name));
     
     if (location == -1)
-        std::cout << "Warning: uniform '" << name << "' doesn't exist!" << std::endl;
+        std::cout << "Warning: uniform '" << uniform.Name << "' doesn't exist!" << std::endl;
 
-    m_UniformLocationCache[name] = location;
+    m_UniformLocationCache.insert(it, { uniform.Hash, location, uniform.Name });
     return location;
 }
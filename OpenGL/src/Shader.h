@@ -1,42 +1,191 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "glm/glm.hpp"
 
+#include "MappedFile.h"
+
+// FNV-1a, constexpr so string literals can be hashed at compile time
+constexpr uint32_t HashUniformName(const char* name)
+{
+	uint32_t hash = 2166136261u;
+	while (*name)
+	{
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// A uniform name with its hash. Literals convert implicitly so SetUniform*("u_Color", ...)
+// never builds a std::string; declare one constexpr to hash it at compile time:
+//   static constexpr UniformHandle s_Color("u_Color");
+// Only the pointer is kept, so a handle must not outlive the name. There's deliberately no
+// std::string constructor, pass name.c_str() for a one off call and never store that handle.
+struct UniformHandle
+{
+	uint32_t Hash;
+	const char* Name;
+
+	constexpr UniformHandle(const char* name)
+		: Hash(HashUniformName(name)), Name(name) {}
+};
+
+enum class ShaderType
+{
+	NONE = -1, VERTEX = 0, FRAGMENT = 1, GEOMETRY = 2, COMPUTE = 3
+};
+const int ShaderTypeCount = 4;
+
+// What reflection found in a linked program
+struct ShaderUniform
+{
+	std::string Name; // Arrays without the "[0]"
+	unsigned int Type;
+	int Size;         // Array length, 1 otherwise
+	int Location;     // -1 for uniform block members
+	int BlockIndex;   // -1 for default block uniforms
+};
+
+struct ShaderAttribute
+{
+	std::string Name;
+	unsigned int Type;
+	int Size;
+	int Location;
+};
+
+struct ShaderUniformBlock
+{
+	std::string Name;
+	unsigned int Index;
+	int DataSize;
+	int Binding;
+};
+
+class VertexBufferLayout;
+
+// A piece of a stage's source, either inside a mapped file or one of the parser's own strings
+struct ShaderSourceSpan
+{
+	const char* Data;
+	int Length;
+};
+
+// Preprocessed source for every stage as spans that go straight to glShaderSource,
+// so file contents are never copied. Empty stages are skipped.
 struct ShaderProgramSource
 {
-	std::string VertexShaderSource;
-	std::string FragmentShaderSource;
+	std::vector<ShaderSourceSpan> Sources[ShaderTypeCount];
+	std::vector<std::string> Files; // The shader file followed by everything it included
+
+	// What the spans point into, only has to live until glShaderSource has copied it
+	std::vector<std::unique_ptr<MappedFile>> Mappings; // Same order as Files
+	std::deque<std::string> Generated; // Defines and #line directives, a deque so the strings never move
+
+	ShaderProgramSource() = default;
+	ShaderProgramSource(ShaderProgramSource&&) = default;
+	ShaderProgramSource(const ShaderProgramSource&) = delete;
+	ShaderProgramSource& operator=(const ShaderProgramSource&) = delete;
 };
 
 class Shader
 {
 private:
 	std::string m_FilePath;
+	std::vector<std::string> m_Defines;
+	std::vector<std::string> m_Files;
 	unsigned int m_RendererID;
-	std::unordered_map<std::string, int> m_UniformLocationCache;
+
+	// Compiles and links in flight, checked on first use
+	struct PendingStage
+	{
+		unsigned int Type;
+		unsigned int ID;
+	};
+	mutable std::vector<PendingStage> m_PendingStages;
+	mutable bool m_Pending;
+	uint64_t m_CacheKey;
+
+	// Sorted by hash, lookups are a binary search and never allocate. Filled with every
+	// active uniform when the program finishes linking, so draws never query GL.
+	struct UniformSlot
+	{
+		uint32_t Hash;
+		int Location;
+		std::string Name; // Only read on insert, and on lookups in debug builds to catch collisions
+	};
+	mutable std::vector<UniformSlot> m_UniformLocationCache;
+
+	// Reflection, refreshed by FinishProgram after every successful link
+	mutable std::vector<ShaderUniform> m_Uniforms;
+	mutable std::vector<ShaderAttribute> m_Attributes;
+	mutable std::vector<ShaderUniformBlock> m_UniformBlocks;
 
 public:
-	Shader(const std::string& filepath);
+	// Async returns right after issuing the compiles and link, status is checked on
+	// the first Bind() or uniform access. Create many shaders this way before using
+	// any of them so the driver can compile them in parallel.
+	Shader(const std::string& filepath, bool async = false);
+	// Each define is "NAME" or "NAME VALUE" ("NAME=VALUE" works too) and is
+	// inserted after the #version line of every stage
+	Shader(const std::string& filepath, const std::vector<std::string>& defines, bool async = false);
 	~Shader();
 
 	void Bind() const;
 	void Unbind() const;
 
+	// False while an async compile is still running, binding before then blocks.
+	// Always true without KHR_parallel_shader_compile since that can't be asked.
+	bool IsReady() const;
+
+	// Lets the driver compile on multiple threads, call once after context creation
+	static void EnableParallelCompile();
+
+	// Recompiles from m_FilePath. On success the new program replaces the old one with
+	// the old uniform values and block bindings copied over, on failure nothing changes.
+	bool Reload();
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline const std::vector<std::string>& GetDefines() const { return m_Defines; }
+	// Every file the last parse read, includes too, so watchers know what to look at
+	inline const std::vector<std::string>& GetFiles() const { return m_Files; }
+
 	// Set Uniforms
-	void SetUniform1i(const std::string& name, int value);
-	void SetUniform1f(const std::string& name, float value);
-	void SetUniform4f(const std::string& name, float f0, float f1, float f2, float f3);
-	void SetUniform4f(const std::string& name, const glm::vec4& v);
-	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+	void SetUniform1i(const UniformHandle& uniform, int value);
+	void SetUniform1iv(const UniformHandle& uniform, int count, const int* values);
+	void SetUniform1f(const UniformHandle& uniform, float value);
+	void SetUniform4f(const UniformHandle& uniform, float f0, float f1, float f2, float f3);
+	void SetUniform4f(const UniformHandle& uniform, const glm::vec4& v);
+	void SetUniformMat4f(const UniformHandle& uniform, const glm::mat4& matrix);
+
+	// Connects a uniform block to a UniformBuffer binding point
+	void SetUniformBlockBinding(const std::string& blockName, unsigned int binding);
+
+	// Reflection, these wait for an async compile to finish
+	const std::vector<ShaderUniform>& GetUniforms() const;
+	const std::vector<ShaderAttribute>& GetAttributes() const;
+	const std::vector<ShaderUniformBlock>& GetUniformBlocks() const;
+	const ShaderAttribute* FindAttribute(const std::string& name) const;
+
+	// Checks a layout added to a VertexArray starting at 'firstLocation' against the
+	// program's inputs the way VertexArray::AddBuffer assigns locations. Logs every
+	// problem and returns false on the ones that would read garbage.
+	bool ValidateLayout(const VertexBufferLayout& layout, unsigned int firstLocation = 0) const;
 
 
 private:
 	ShaderProgramSource ParseShader(const std::string& filepath);
-	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
+	unsigned int CompileShader(unsigned int type, const std::vector<ShaderSourceSpan>& source);
+	unsigned int CreateShader(const ShaderProgramSource& source);
+	bool FinishProgram() const;
+	void Reflect() const;
 
-	int GetUniformLocation(const std::string& name);
+	int GetUniformLocation(const UniformHandle& uniform);
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+
+std::vector<std::string> ShaderLibrary::NormalizeDefines(std::vector<std::string> defines)
+{
+    // "NAME=VALUE" and "NAME VALUE" are the same define
+    for (std::string& define : defines)
+    {
+        size_t equals = define.find('=');
+        if (equals != std::string::npos)
+            define[equals] = ' ';
+    }
+
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+    return defines;
+}
+
+std::string ShaderLibrary::MakeKey(const std::string& filepath, std::vector<std::string> defines)
+{
+    std::string key = filepath;
+    for (const std::string& define : NormalizeDefines(std::move(defines)))
+    {
+        // Newlines can't appear in either part, so keys can't run together
+        key += '\n';
+        key += define;
+    }
+    return key;
+}
+
+Shader& ShaderLibrary::Get(const std::string& filepath, const std::vector<std::string>& defines, bool async)
+{
+    std::vector<std::string> normalized = NormalizeDefines(defines);
+    std::string key = MakeKey(filepath, normalized);
+
+    auto it = m_Shaders.find(key);
+    if (it != m_Shaders.end())
+        return *it->second;
+
+    std::unique_ptr<Shader> shader(new Shader(filepath, normalized, async));
+    Shader& result = *shader;
+    m_Shaders.emplace(std::move(key), std::move(shader));
+    return result;
+}
+
+bool ShaderLibrary::Contains(const std::string& filepath, const std::vector<std::string>& defines) const
+{
+    return m_Shaders.find(MakeKey(filepath, defines)) != m_Shaders.end();
+}
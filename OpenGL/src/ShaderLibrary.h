@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+
+// Owns one Shader per file and define set, so a single source file can be
+// specialized into many programs instead of branching at runtime in GLSL.
+// The define set is sorted first, {"A", "B"} and {"B", "A"} share a program.
+class ShaderLibrary
+{
+private:
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Shaders;
+
+public:
+	// Compiles the permutation the first time it's asked for, see Shader for async
+	Shader& Get(const std::string& filepath, const std::vector<std::string>& defines = {}, bool async = false);
+	bool Contains(const std::string& filepath, const std::vector<std::string>& defines = {}) const;
+
+	inline size_t GetCount() const { return m_Shaders.size(); }
+
+	// Visits every compiled permutation, e.g. to hand them to a ShaderWatcher
+	template<typename F>
+	void ForEach(F&& function)
+	{
+		for (auto& entry : m_Shaders)
+			function(*entry.second);
+	}
+
+	static std::string MakeKey(const std::string& filepath, std::vector<std::string> defines);
+	static std::vector<std::string> NormalizeDefines(std::vector<std::string> defines);
+};
@@ -0,0 +1,315 @@
+#include "ShaderWatcher.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sys/stat.h>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <cstring>
+#endif
+
+struct ShaderWatcher::DirectoryWatch
+{
+    std::string Directory;
+#ifdef _WIN32
+    HANDLE Handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED Overlapped = {};
+    DWORD Buffer[4096]; // ReadDirectoryChangesW wants it DWORD aligned
+#endif
+};
+
+// Seconds between modification time polls when inotify isn't available
+static const double s_PollInterval = 0.25;
+
+static double Now()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Time is -1 if the file can't be read. Whole seconds aren't enough, two saves in
+// the same second would look like one, so the size is compared too.
+static void GetFileStamp(const std::string& path, long long& modifiedTime, long long& size)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info))
+    {
+        modifiedTime = -1;
+        return;
+    }
+    // 100 ns ticks
+    modifiedTime = ((long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+    size = ((long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        modifiedTime = -1;
+        return;
+    }
+    #ifdef __linux__
+        modifiedTime = (long long)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+    #else
+        modifiedTime = (long long)info.st_mtime;
+    #endif
+    size = (long long)info.st_size;
+#endif
+}
+
+#ifdef _WIN32
+bool ShaderWatcher::IssueRead(DirectoryWatch& watch)
+{
+    watch.Overlapped = {};
+    // File name covers editors that save to a temporary file and rename it over the original
+    DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    return ReadDirectoryChangesW(watch.Handle, watch.Buffer, sizeof(watch.Buffer), FALSE, filter, nullptr, &watch.Overlapped, nullptr) != 0;
+}
+
+static std::string ToUtf8(const WCHAR* text, int length)
+{
+    int size = WideCharToMultiByte(CP_UTF8, 0, text, length, nullptr, 0, nullptr, nullptr);
+    std::string result(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, length, &result[0], size, nullptr, nullptr);
+    return result;
+}
+#endif
+
+static void SplitPath(const std::string& path, std::string& directory, std::string& fileName)
+{
+    size_t slash = path.find_last_of("/\\");
+    if (slash == std::string::npos)
+    {
+        directory = ".";
+        fileName = path;
+    }
+    else
+    {
+        directory = path.substr(0, slash);
+        fileName = path.substr(slash + 1);
+    }
+}
+
+ShaderWatcher::ShaderWatcher()
+    : m_NotifyFD(-1), m_DirectoryWatchFailed(false), m_LastPoll(0.0)
+{
+#ifdef __linux__
+    m_NotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef __linux__
+    if (m_NotifyFD >= 0)
+        close(m_NotifyFD);
+#endif
+#ifdef _WIN32
+    for (auto& watch : m_DirectoryWatches)
+    {
+        // The kernel writes into Buffer until the request is really gone
+        DWORD bytes;
+        CancelIoEx(watch->Handle, &watch->Overlapped);
+        GetOverlappedResult(watch->Handle, &watch->Overlapped, &bytes, TRUE);
+        CloseHandle(watch->Handle);
+    }
+#endif
+}
+
+void ShaderWatcher::Watch(Shader& shader)
+{
+    // One entry per file, a shared include reloads every shader using it
+    for (const std::string& path : shader.GetFiles())
+    {
+        Entry entry;
+        entry.Target = &shader;
+        entry.Path = path;
+        SplitPath(path, entry.Directory, entry.FileName);
+        GetFileStamp(path, entry.ModifiedTime, entry.Size);
+        m_Entries.push_back(entry);
+
+        AddDirectory(entry.Directory);
+    }
+}
+
+void ShaderWatcher::Unwatch(Shader& shader)
+{
+    m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(),
+        [&shader](const Entry& entry) { return entry.Target == &shader; }), m_Entries.end());
+}
+
+void ShaderWatcher::AddDirectory(const std::string& directory)
+{
+#ifdef __linux__
+    if (m_NotifyFD < 0)
+        return;
+
+    for (const auto& watched : m_WatchedDirectories)
+        if (watched.second == directory)
+            return;
+    if (std::find(m_PolledDirectories.begin(), m_PolledDirectories.end(), directory) != m_PolledDirectories.end())
+        return;
+
+    // Watch the directory rather than the file, editors often save by writing a new file and renaming it
+    int wd = inotify_add_watch(m_NotifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd >= 0)
+        m_WatchedDirectories.push_back({ wd, directory });
+    else
+        m_PolledDirectories.push_back(directory);
+#elif defined(_WIN32)
+    for (const auto& watch : m_DirectoryWatches)
+        if (watch->Directory == directory)
+            return;
+
+    std::unique_ptr<DirectoryWatch> watch(new DirectoryWatch());
+    watch->Directory = directory;
+    watch->Handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (watch->Handle == INVALID_HANDLE_VALUE || !IssueRead(*watch))
+    {
+        if (watch->Handle != INVALID_HANDLE_VALUE)
+            CloseHandle(watch->Handle);
+        m_DirectoryWatchFailed = true;
+        return;
+    }
+    m_DirectoryWatches.push_back(std::move(watch));
+#else
+    (void)directory;
+#endif
+}
+
+void ShaderWatcher::CollectNotifications(std::vector<Shader*>& changed)
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t length = read(m_NotifyFD, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len)
+        {
+            const inotify_event* event = (const inotify_event*)ptr;
+            if (event->len == 0)
+                continue;
+
+            const std::string* directory = nullptr;
+            for (const auto& watched : m_WatchedDirectories)
+                if (watched.first == event->wd)
+                    directory = &watched.second;
+            if (!directory)
+                continue;
+
+            for (const Entry& entry : m_Entries)
+                if (entry.Directory == *directory && entry.FileName == event->name)
+                    changed.push_back(entry.Target);
+        }
+    }
+#else
+    (void)changed;
+#endif
+}
+
+void ShaderWatcher::CollectDirectoryChanges(std::vector<Shader*>& changed)
+{
+#ifdef _WIN32
+    for (auto& watch : m_DirectoryWatches)
+    {
+        if (!HasOverlappedIoCompleted(&watch->Overlapped))
+            continue;
+
+        DWORD bytes = 0;
+        if (GetOverlappedResult(watch->Handle, &watch->Overlapped, &bytes, FALSE))
+        {
+            // Zero bytes means the buffer overflowed and the names are lost, reload the whole directory
+            const char* ptr = (const char*)watch->Buffer;
+            for (;;)
+            {
+                const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)ptr;
+                std::string name = bytes ? ToUtf8(info->FileName, (int)(info->FileNameLength / sizeof(WCHAR))) : "";
+
+                for (const Entry& entry : m_Entries)
+                {
+                    if (entry.Directory == watch->Directory && (!bytes || _stricmp(entry.FileName.c_str(), name.c_str()) == 0))
+                        changed.push_back(entry.Target);
+                }
+
+                if (!bytes || info->NextEntryOffset == 0)
+                    break;
+                ptr += info->NextEntryOffset;
+            }
+        }
+
+        if (!IssueRead(*watch))
+            m_DirectoryWatchFailed = true;
+    }
+#else
+    (void)changed;
+#endif
+}
+
+void ShaderWatcher::CollectModified(std::vector<Shader*>& changed, bool all)
+{
+    double now = Now();
+    if (now - m_LastPoll < s_PollInterval)
+        return;
+    m_LastPoll = now;
+
+    for (Entry& entry : m_Entries)
+    {
+        if (!all && std::find(m_PolledDirectories.begin(), m_PolledDirectories.end(), entry.Directory) == m_PolledDirectories.end())
+            continue;
+
+        long long modified, size = entry.Size;
+        GetFileStamp(entry.Path, modified, size);
+        if (modified != -1 && (modified != entry.ModifiedTime || size != entry.Size))
+        {
+            entry.ModifiedTime = modified;
+            entry.Size = size;
+            changed.push_back(entry.Target);
+        }
+    }
+}
+
+unsigned int ShaderWatcher::Update()
+{
+    std::vector<Shader*> changed;
+    if (m_NotifyFD >= 0)
+    {
+        CollectNotifications(changed);
+        if (!m_PolledDirectories.empty())
+            CollectModified(changed, false);
+    }
+#ifdef _WIN32
+    else if (!m_DirectoryWatchFailed)
+        CollectDirectoryChanges(changed);
+#endif
+    else
+        CollectModified(changed);
+
+    // A save can produce several events, reload each shader once
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    unsigned int reloaded = 0;
+    for (Shader* shader : changed)
+    {
+        if (shader->Reload())
+            reloaded++;
+
+        // The edit may have added or removed includes
+        Unwatch(*shader);
+        Watch(*shader);
+    }
+    return reloaded;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Shader;
+
+// Reloads shaders when their source files or anything they #include change on disk. Uses inotify on
+// Linux and ReadDirectoryChangesW on Windows, and falls back to polling modification times and
+// sizes elsewhere. Update() never blocks; it only recompiles shaders whose files actually changed.
+class ShaderWatcher
+{
+private:
+	struct Entry
+	{
+		Shader* Target;
+		std::string Path;
+		std::string Directory;
+		std::string FileName;
+		long long ModifiedTime; // Finest resolution the platform has, only for polling
+		long long Size;
+	};
+	std::vector<Entry> m_Entries;
+
+	int m_NotifyFD;
+	std::vector<std::pair<int, std::string>> m_WatchedDirectories; // inotify watch descriptor, directory
+	std::vector<std::string> m_PolledDirectories; // inotify_add_watch failed, out of watches or missing
+
+	// Windows only, an open directory with a ReadDirectoryChangesW request in flight
+	struct DirectoryWatch;
+	std::vector<std::unique_ptr<DirectoryWatch>> m_DirectoryWatches;
+	bool m_DirectoryWatchFailed; // Poll everything instead
+
+	double m_LastPoll;
+
+public:
+	ShaderWatcher();
+	~ShaderWatcher();
+
+	void Watch(Shader& shader);
+	void Unwatch(Shader& shader);
+
+	// Call once per frame on the render thread, returns how many shaders were reloaded
+	unsigned int Update();
+
+private:
+	void AddDirectory(const std::string& directory);
+	void CollectNotifications(std::vector<Shader*>& changed);
+	void CollectDirectoryChanges(std::vector<Shader*>& changed);
+	static bool IssueRead(DirectoryWatch& watch);
+	// Only entries in m_PolledDirectories unless 'all'
+	void CollectModified(std::vector<Shader*>& changed, bool all = true);
+};
@@ -1,42 +1,238 @@
 #include "Texture.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+#include "Mipmap.h"
+#include "TextureFile.h"
 #include "stb_image/stb_image.h"
 
-Texture::Texture(const std::string& path)
-	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0)
+#include <algorithm>
+#include <iostream>
+
+Texture::Texture(const std::string& path, const TextureSpec& spec)
+	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0),
+	  m_Levels(1), m_Format(GL_RGBA8), m_Spec(spec), m_Placeholder(nullptr), m_Handle(0)
 {
+	// Already in GPU format, no decoding
+	if (TextureFile::IsTextureFile(path))
+	{
+		TextureFile file(path);
+		if (file.IsValid())
+			Create(file);
+		else
+			std::cout << "Failed to load texture " << path << ": " << file.GetError() << std::endl;
+		return;
+	}
+
 	// Load texture from file
 	stbi_set_flip_vertically_on_load(1);
 	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
 
+	Create(m_Width, m_Height, m_LocalBuffer);
+
+	if (m_LocalBuffer)
+		stbi_image_free(m_LocalBuffer);
+	m_LocalBuffer = nullptr;
+}
+
+Texture::Texture(int width, int height, const unsigned char* data, const TextureSpec& spec)
+	: m_RendererID(0), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(4),
+	  m_Levels(1), m_Format(GL_RGBA8), m_Spec(spec), m_Placeholder(nullptr), m_Handle(0)
+{
+	Create(width, height, data);
+}
+
+Texture::Texture(const Texture* placeholder, const TextureSpec& spec)
+	: m_RendererID(0), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(4),
+	  m_Levels(1), m_Format(GL_RGBA8), m_Spec(spec), m_Placeholder(placeholder), m_Handle(0)
+{
+}
+
+Texture::~Texture()
+{
+	GPUMemory::Free(this);
+	if (m_Handle)
+	{
+		GLCall(glMakeTextureHandleNonResidentARB(m_Handle));
+	}
+	if (m_RendererID)
+	{
+		GLCall(glDeleteTextures(1, &m_RendererID));
+		GLState::OnTextureDeleted(m_RendererID);
+	}
+}
+
+void Texture::Create(int width, int height, const unsigned char* data)
+{
+	m_Width = width;
+	m_Height = height;
+	m_Levels = m_Spec.Mipmaps == TextureMipmaps::None ? 1 : MipLevelCount(width, height);
+
 	// Generate gl texture
 	GLCall(glGenTextures(1, &m_RendererID));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, m_RendererID);
 
 	// Set parameters
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	ApplySampling();
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	// CPU filtered levels are ready before anything is allocated, so they go up with their storage
+	std::vector<MipLevel> chain;
+	if (data && (m_Spec.Mipmaps == TextureMipmaps::Box || m_Spec.Mipmaps == TextureMipmaps::Kaiser))
+		chain = GenerateMipChain(data, width, height, m_Spec.Mipmaps == TextureMipmaps::Box ? MipFilter::Box : MipFilter::Kaiser);
 
-	if (m_LocalBuffer)
-		stbi_image_free(m_LocalBuffer);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
+	for (int level = 1; level < m_Levels; level++)
+	{
+		int levelWidth = std::max(m_Width >> level, 1);
+		int levelHeight = std::max(m_Height >> level, 1);
+		const unsigned char* pixels = level - 1 < (int)chain.size() ? chain[level - 1].Pixels.data() : nullptr;
+		GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	}
+
+	if (data && m_Spec.Mipmaps == TextureMipmaps::GPU)
+		GenerateMipmaps();
+
+	GPUMemory::Allocate(this, GPUMemoryCategory::Texture, GetMemorySize(), m_RendererID, m_FilePath);
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, 0);
 }
 
-Texture::~Texture()
+void Texture::Create(const TextureFile& file)
+{
+	const std::vector<TextureFile::Level>& levels = file.GetLevels();
+	m_Width = file.GetWidth();
+	m_Height = file.GetHeight();
+	m_Format = file.GetFormat();
+
+	if (!TextureFile::IsFormatSupported(m_Format))
+	{
+		std::cout << "Warning: " << m_FilePath << " uses a texture format the driver doesn't support" << std::endl;
+		return;
+	}
+
+	// Compressed levels can't be generated on the GPU, only what the file has is used
+	m_Levels = m_Spec.Mipmaps == TextureMipmaps::None ? 1 : (int)levels.size();
+	if (m_Levels == 1 && m_Spec.Mipmaps != TextureMipmaps::None && file.IsCompressed())
+		std::cout << "Warning: " << m_FilePath << " has no mip chain, bake one in" << std::endl;
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, m_RendererID);
+	ApplySampling();
+
+	for (int level = 0; level < m_Levels; level++)
+	{
+		const TextureFile::Level& source = levels[level];
+		if (file.IsCompressed())
+		{
+			GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, m_Format, source.Width, source.Height, 0, (GLsizei)source.Size, source.Data));
+		}
+		else
+		{
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, m_Format, source.Width, source.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source.Data));
+		}
+	}
+
+	// An uncompressed file without mips can still have them generated
+	if (m_Spec.Mipmaps == TextureMipmaps::GPU && levels.size() == 1 && !file.IsCompressed())
+	{
+		m_Levels = MipLevelCount(m_Width, m_Height);
+		ApplySampling();
+		GenerateMipmaps();
+	}
+
+	GPUMemory::Allocate(this, GPUMemoryCategory::Texture, GetMemorySize(), m_RendererID, m_FilePath);
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, 0);
+}
+
+void Texture::Share(const std::shared_ptr<const Texture>& source)
+{
+	// Binding falls through to the placeholder while there's no image of our own,
+	// holding on to the source keeps that pointer valid
+	m_Source = source;
+	m_Placeholder = source.get();
+}
+
+void ApplyTextureSpec(unsigned int target, const TextureSpec& spec, int levels)
+{
+	GLint minFilter = GL_LINEAR;
+	if (levels > 1)
+		minFilter = spec.Trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+
+	GLCall(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter));
+	GLCall(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_S, spec.Wrap));
+	GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_T, spec.Wrap));
+	GLCall(glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1));
+
+	// Core in 4.6, an extension everywhere that matters before that
+	if (spec.Anisotropy > 1.0f && (GLEW_ARB_texture_filter_anisotropic || GLEW_EXT_texture_filter_anisotropic))
+	{
+		static float s_MaxAnisotropy = 0.0f;
+		if (s_MaxAnisotropy == 0.0f)
+		{
+			GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &s_MaxAnisotropy));
+		}
+		GLCall(glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY, std::min(spec.Anisotropy, s_MaxAnisotropy)));
+	}
+}
+
+void Texture::ApplySampling() const
+{
+	// Expects the texture to be bound
+	ApplyTextureSpec(GL_TEXTURE_2D, m_Spec, m_Levels);
+}
+
+void Texture::SetSubImage(int x, int y, int width, int height, const void* pixels, int level) const
+{
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, m_RendererID);
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+}
+
+void Texture::GenerateMipmaps() const
+{
+	if (m_Levels <= 1)
+		return;
+
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, m_RendererID);
+	GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+}
+
+size_t Texture::GetMemorySize() const
+{
+	if (!m_RendererID)
+		return 0;
+
+	size_t size = 0;
+	for (int level = 0; level < m_Levels; level++)
+		size += TextureFile::GetLevelSize(m_Format, std::max(m_Width >> level, 1), std::max(m_Height >> level, 1));
+	return size;
+}
+
+uint64_t Texture::GetBindlessHandle() const
+{
+	if (!m_RendererID)
+		return m_Placeholder ? m_Placeholder->GetBindlessHandle() : 0;
+
+	if (!m_Handle)
+	{
+		GLCall(m_Handle = glGetTextureHandleARB(m_RendererID));
+		GLCall(glMakeTextureHandleResidentARB(m_Handle));
+	}
+	return m_Handle;
+}
+
+bool Texture::IsBindlessSupported()
 {
-	GLCall(glDeleteTextures(1, &m_RendererID));
+	return GLEW_ARB_bindless_texture != GL_FALSE;
 }
 
 void Texture::Bind(unsigned int slot) const
 {
-	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	if (!m_RendererID && m_Placeholder)
+		m_Placeholder->Bind(slot);
+	else
+		GLState::BindTexture(slot, GL_TEXTURE_2D, m_RendererID);
 }
 
 void Texture::Unbind() const
 {
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D, 0);
 }
@@ -1,7 +1,38 @@
 #pragma once
 
+#include <memory>
+
 #include "Renderer.h"
 
+class TextureFile;
+
+// The CPU filters average in linear light, glGenerateMipmap averages the stored RGBA8 values
+// as they are, in gamma space. Minified textures come out darker with GPU, most visibly on
+// high contrast detail, so switching between it and Box or Kaiser changes the look too.
+enum class TextureMipmaps
+{
+	None,  // Level 0 only
+	GPU,   // glGenerateMipmap after every upload, gamma space
+	Box,   // Filtered on the CPU in linear light, see Mipmap.h
+	Kaiser
+};
+
+struct TextureSpec
+{
+	TextureMipmaps Mipmaps = TextureMipmaps::None;
+	bool Trilinear = true;   // Blend between the two nearest mip levels instead of picking one
+	float Anisotropy = 1.0f; // Clamped to what the driver supports, 1 turns it off
+	unsigned int Wrap = GL_CLAMP_TO_EDGE;
+};
+
+inline bool operator==(const TextureSpec& a, const TextureSpec& b)
+{
+	return a.Mipmaps == b.Mipmaps && a.Trilinear == b.Trilinear && a.Anisotropy == b.Anisotropy && a.Wrap == b.Wrap;
+}
+
+// Filters, wrapping, level range and anisotropy for the texture bound to 'target'
+void ApplyTextureSpec(unsigned int target, const TextureSpec& spec, int levels);
+
 class Texture
 {
 private:
@@ -9,14 +40,54 @@ private:
 	std::string m_FilePath;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	int m_Levels;
+	unsigned int m_Format; // GL internal format, GL_RGBA8 unless loaded from a TextureFile
+	TextureSpec m_Spec;
+	const Texture* m_Placeholder; // Bound instead until the image has been uploaded
+	mutable uint64_t m_Handle;    // Bindless, 0 until asked for
+	std::shared_ptr<const Texture> m_Source; // Same file under another path, used instead of an image of its own
 
 public:
-	Texture(const std::string& path);
+	// .ktx2 and .dds files upload as stored (see TextureFile), anything else goes through stb_image
+	Texture(const std::string& path, const TextureSpec& spec = TextureSpec());
+	Texture(int width, int height, const unsigned char* data, const TextureSpec& spec = TextureSpec()); // RGBA8 pixels
+	// No image yet, binding it binds 'placeholder' instead. TextureLoader fills it in later.
+	explicit Texture(const Texture* placeholder, const TextureSpec& spec = TextureSpec());
 	~Texture();
 
 	void Bind(unsigned int slot = 0) const;
 	void Unbind() const;
 
-	inline int GetWidth() const { return m_Width; }
-	inline int GetHeight() const { return m_Height; }
-};
\ No newline at end of file
+	// Replaces part of a level with RGBA8 pixels. With a pixel unpack buffer
+	// bound 'pixels' is an offset into it, see PixelBufferRing.
+	void SetSubImage(int x, int y, int width, int height, const void* pixels, int level = 0) const;
+	// Rebuilds every level past 0 on the GPU, for after changing level 0
+	void GenerateMipmaps() const;
+
+	// ARB_bindless_texture handle, made resident on first use. Sampling state can't change
+	// after this, so only ask once the texture is finished. Unloaded textures return the
+	// placeholder's handle.
+	uint64_t GetBindlessHandle() const;
+	static bool IsBindlessSupported();
+
+	// Textures sharing another one's image answer with the other's
+	inline bool IsLoaded() const { return m_Source ? m_Source->IsLoaded() : m_RendererID != 0; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline unsigned int GetRendererID() const { return m_Source ? m_Source->GetRendererID() : m_RendererID; }
+	inline int GetWidth() const { return m_Source ? m_Source->GetWidth() : m_Width; }
+	inline int GetHeight() const { return m_Source ? m_Source->GetHeight() : m_Height; }
+	inline int GetLevelCount() const { return m_Source ? m_Source->GetLevelCount() : m_Levels; }
+	inline unsigned int GetFormat() const { return m_Source ? m_Source->GetFormat() : m_Format; }
+	inline const TextureSpec& GetSpec() const { return m_Spec; }
+	// Bytes of video memory every level takes, 0 until loaded and for shared images,
+	// which count towards the texture that owns them
+	size_t GetMemorySize() const;
+
+private:
+	friend class TextureLoader;
+	void Create(int width, int height, const unsigned char* data);
+	void Create(const TextureFile& file);
+	// Binds 'source' from now on, for files identical to one already loaded
+	void Share(const std::shared_ptr<const Texture>& source);
+	void ApplySampling() const;
+};
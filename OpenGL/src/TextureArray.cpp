@@ -0,0 +1,99 @@
+#include "TextureArray.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+#include "Mipmap.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <iostream>
+
+TextureArray::TextureArray(int width, int height, int layers, const TextureSpec& spec)
+    : m_RendererID(0), m_Width(width), m_Height(height), m_Layers(layers), m_Spec(spec)
+{
+    m_Levels = m_Spec.Mipmaps == TextureMipmaps::None ? 1 : MipLevelCount(width, height);
+
+    GLCall(glGenTextures(1, &m_RendererID));
+    GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D_ARRAY, m_RendererID);
+    ApplyTextureSpec(GL_TEXTURE_2D_ARRAY, m_Spec, m_Levels);
+
+    for (int level = 0; level < m_Levels; level++)
+    {
+        int levelWidth = std::max(m_Width >> level, 1);
+        int levelHeight = std::max(m_Height >> level, 1);
+        GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelWidth, levelHeight, m_Layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    }
+
+    size_t size = 0;
+    for (int level = 0; level < m_Levels; level++)
+        size += (size_t)std::max(m_Width >> level, 1) * std::max(m_Height >> level, 1) * 4 * m_Layers;
+    GPUMemory::Allocate(this, GPUMemoryCategory::Texture, size, m_RendererID, std::to_string(m_Layers) + " layer array");
+
+    GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArray::~TextureArray()
+{
+    GPUMemory::Free(this);
+    GLCall(glDeleteTextures(1, &m_RendererID));
+    GLState::OnTextureDeleted(m_RendererID);
+}
+
+void TextureArray::SetLayer(int layer, const unsigned char* pixels)
+{
+    ASSERT(layer >= 0 && layer < m_Layers);
+
+    SetSubImage(layer, 0, 0, m_Width, m_Height, pixels);
+
+    if (m_Levels > 1 && (m_Spec.Mipmaps == TextureMipmaps::Box || m_Spec.Mipmaps == TextureMipmaps::Kaiser))
+    {
+        std::vector<MipLevel> chain = GenerateMipChain(pixels, m_Width, m_Height, m_Spec.Mipmaps == TextureMipmaps::Box ? MipFilter::Box : MipFilter::Kaiser);
+        for (size_t i = 0; i < chain.size(); i++)
+            SetSubImage(layer, 0, 0, chain[i].Width, chain[i].Height, chain[i].Pixels.data(), (int)i + 1);
+    }
+}
+
+bool TextureArray::SetLayer(int layer, const std::string& path)
+{
+    int width, height, bpp;
+    stbi_set_flip_vertically_on_load(1);
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+    if (!pixels)
+    {
+        std::cout << "Failed to load texture " << path << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    bool fits = width == m_Width && height == m_Height;
+    if (fits)
+        SetLayer(layer, pixels);
+    else
+        std::cout << "Warning: " << path << " is " << width << "x" << height << ", the array's layers are " << m_Width << "x" << m_Height << std::endl;
+
+    stbi_image_free(pixels);
+    return fits;
+}
+
+void TextureArray::SetSubImage(int layer, int x, int y, int width, int height, const void* pixels, int level) const
+{
+    GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D_ARRAY, m_RendererID);
+    GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+}
+
+void TextureArray::GenerateMipmaps() const
+{
+    if (m_Levels <= 1)
+        return;
+
+    GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D_ARRAY, m_RendererID);
+    GLCall(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+    GLState::BindTexture(slot, GL_TEXTURE_2D_ARRAY, m_RendererID);
+}
+
+void TextureArray::Unbind() const
+{
+    GLState::BindTexture(GLState::GetActiveTexture(), GL_TEXTURE_2D_ARRAY, 0);
+}
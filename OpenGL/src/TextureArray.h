@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Texture.h"
+
+// GL_TEXTURE_2D_ARRAY of same sized RGBA8 layers. One bind gives a shader every layer,
+// picked by the third texture coordinate, so textures that share a size never split a batch.
+class TextureArray
+{
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height;
+	int m_Layers;
+	int m_Levels;
+	TextureSpec m_Spec;
+
+public:
+	// Every level of every layer is allocated up front, layers start out undefined
+	TextureArray(int width, int height, int layers, const TextureSpec& spec = TextureSpec());
+	~TextureArray();
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	// Fills a whole layer with width x height RGBA8 pixels, plus its mips when the spec
+	// asks for CPU filtered ones. GPU mips are generated for all layers at once by
+	// GenerateMipmaps(), call it after the last SetLayer().
+	void SetLayer(int layer, const unsigned char* pixels);
+	// Loads a file into a layer, flipped like Texture. False if it can't be read or is the wrong size.
+	bool SetLayer(int layer, const std::string& path);
+	// Same as Texture::SetSubImage, for one layer
+	void SetSubImage(int layer, int x, int y, int width, int height, const void* pixels, int level = 0) const;
+	void GenerateMipmaps() const;
+
+	void Bind(unsigned int slot = 0) const;
+	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetLayerCount() const { return m_Layers; }
+	inline int GetLevelCount() const { return m_Levels; }
+	inline const TextureSpec& GetSpec() const { return m_Spec; }
+};
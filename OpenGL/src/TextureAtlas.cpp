@@ -0,0 +1,160 @@
+#include "TextureAtlas.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// ImGui compiles its copy static, so this file has its own
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+TextureAtlas::TextureAtlas(int pageSize, int padding, const TextureSpec& spec)
+    : m_PageSize(pageSize), m_Padding(padding), m_Spec(spec), m_Built(false)
+{
+}
+
+unsigned int TextureAtlas::Add(const std::string& path)
+{
+    int width, height, bpp;
+    stbi_set_flip_vertically_on_load(1);
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+    if (!pixels)
+    {
+        std::cout << "Failed to load atlas image " << path << ": " << stbi_failure_reason() << std::endl;
+        return InvalidRegion;
+    }
+
+    Image image;
+    image.Width = width;
+    image.Height = height;
+    image.Pixels.assign(pixels, pixels + (size_t)width * height * 4);
+    stbi_image_free(pixels);
+
+    return AddImage(path, std::move(image));
+}
+
+unsigned int TextureAtlas::Add(const std::string& name, int width, int height, const unsigned char* pixels)
+{
+    Image image;
+    image.Width = width;
+    image.Height = height;
+    image.Pixels.assign(pixels, pixels + (size_t)width * height * 4);
+
+    return AddImage(name, std::move(image));
+}
+
+unsigned int TextureAtlas::AddImage(const std::string& name, Image&& image)
+{
+    if (m_Built)
+    {
+        std::cout << "Warning: " << name << " added to an atlas that was already built" << std::endl;
+        return InvalidRegion;
+    }
+
+    // The same file twice is the same region
+    auto found = m_Names.find(name);
+    if (found != m_Names.end())
+        return found->second;
+
+    unsigned int id = (unsigned int)m_Images.size();
+    m_Images.push_back(std::move(image));
+    m_Regions.push_back({ nullptr, glm::vec2(0.0f), glm::vec2(0.0f), m_Images.back().Width, m_Images.back().Height });
+    m_Names[name] = id;
+    return id;
+}
+
+unsigned int TextureAtlas::Find(const std::string& name) const
+{
+    auto found = m_Names.find(name);
+    return found != m_Names.end() ? found->second : InvalidRegion;
+}
+
+void TextureAtlas::CopyImage(const Image& image, std::vector<unsigned char>& page, int pageWidth, int x, int y) const
+{
+    // Rows and columns past the edges repeat the edge, x and y are the padded corner
+    int paddedWidth = image.Width + m_Padding * 2;
+    for (int row = 0; row < image.Height + m_Padding * 2; row++)
+    {
+        int sourceRow = std::min(std::max(row - m_Padding, 0), image.Height - 1);
+        const unsigned char* source = image.Pixels.data() + (size_t)sourceRow * image.Width * 4;
+        unsigned char* dest = page.data() + ((size_t)(y + row) * pageWidth + x) * 4;
+
+        for (int column = 0; column < m_Padding; column++)
+        {
+            memcpy(dest + column * 4, source, 4);
+            memcpy(dest + (paddedWidth - 1 - column) * 4, source + (image.Width - 1) * 4, 4);
+        }
+        memcpy(dest + m_Padding * 4, source, (size_t)image.Width * 4);
+    }
+}
+
+bool TextureAtlas::Build()
+{
+    if (m_Built)
+        return true;
+    m_Built = true;
+
+    int maxSize;
+    GLCall(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize));
+    int pageSize = std::min(m_PageSize, maxSize);
+
+    std::vector<stbrp_rect> remaining(m_Images.size());
+    for (size_t i = 0; i < m_Images.size(); i++)
+    {
+        remaining[i].id = (int)i;
+        remaining[i].w = (stbrp_coord)(m_Images[i].Width + m_Padding * 2);
+        remaining[i].h = (stbrp_coord)(m_Images[i].Height + m_Padding * 2);
+    }
+
+    std::vector<stbrp_node> nodes(pageSize);
+    bool complete = true;
+    while (!remaining.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, pageSize, pageSize, nodes.data(), (int)nodes.size());
+        stbrp_pack_rects(&context, remaining.data(), (int)remaining.size());
+
+        std::vector<stbrp_rect> packed, unpacked;
+        for (const stbrp_rect& rect : remaining)
+            (rect.was_packed ? packed : unpacked).push_back(rect);
+
+        if (packed.empty())
+        {
+            // Bigger than a page, these keep their regions without a page
+            for (const stbrp_rect& rect : unpacked)
+                std::cout << "Warning: atlas image " << m_Images[rect.id].Width << "x" << m_Images[rect.id].Height <<
+                    " doesn't fit a " << pageSize << "x" << pageSize << " page" << std::endl;
+            complete = false;
+            break;
+        }
+
+        // The last page is usually partly empty, only allocate the rows in use
+        int pageHeight = 0;
+        for (const stbrp_rect& rect : packed)
+            pageHeight = std::max(pageHeight, rect.y + rect.h);
+
+        std::vector<unsigned char> pixels((size_t)pageSize * pageHeight * 4, 0);
+        for (const stbrp_rect& rect : packed)
+            CopyImage(m_Images[rect.id], pixels, pageSize, rect.x, rect.y);
+
+        m_Pages.emplace_back(new Texture(pageSize, pageHeight, pixels.data(), m_Spec));
+        const Texture* page = m_Pages.back().get();
+
+        for (const stbrp_rect& rect : packed)
+        {
+            AtlasRegion& region = m_Regions[rect.id];
+            region.Page = page;
+            region.UVMin = glm::vec2((float)(rect.x + m_Padding) / pageSize, (float)(rect.y + m_Padding) / pageHeight);
+            region.UVMax = region.UVMin + glm::vec2((float)region.Width / pageSize, (float)region.Height / pageHeight);
+        }
+
+        remaining.swap(unpacked);
+    }
+
+    // Everything is on the GPU now
+    m_Images.clear();
+    m_Images.shrink_to_fit();
+    return complete;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Texture.h"
+
+// Where an image ended up, UVs exclude the padding
+struct AtlasRegion
+{
+	const Texture* Page;
+	glm::vec2 UVMin;
+	glm::vec2 UVMax;
+	int Width, Height;
+};
+
+// Packs many small images into a few large pages with stb_rect_pack, so sprites drawn
+// together share a texture and BatchRenderer flushes on quad count instead of on slots.
+// Add everything, Build() once, then draw with the regions.
+class TextureAtlas
+{
+public:
+	static const unsigned int InvalidRegion = ~0u;
+
+private:
+	struct Image
+	{
+		int Width, Height;
+		std::vector<unsigned char> Pixels; // RGBA8, freed by Build()
+	};
+
+	int m_PageSize;
+	int m_Padding;
+	TextureSpec m_Spec;
+	bool m_Built;
+
+	std::vector<Image> m_Images;
+	std::vector<AtlasRegion> m_Regions; // Same index as m_Images
+	std::unordered_map<std::string, unsigned int> m_Names;
+	std::vector<std::unique_ptr<Texture>> m_Pages;
+
+public:
+	// Padding is filled with each image's edge pixels so filtering never reaches a
+	// neighbour, mipmapped pages need about 2^(levels used) of it. Pages are clamped
+	// to GL_MAX_TEXTURE_SIZE.
+	TextureAtlas(int pageSize = 2048, int padding = 2, const TextureSpec& spec = TextureSpec());
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// Both return the region's id, or InvalidRegion if the image couldn't be added.
+	// Files are flipped the same way Texture flips them and named by their path.
+	unsigned int Add(const std::string& path);
+	unsigned int Add(const std::string& name, int width, int height, const unsigned char* pixels); // RGBA8
+
+	// Packs and uploads every page, after this nothing more can be added
+	bool Build();
+
+	const AtlasRegion& GetRegion(unsigned int id) const { return m_Regions[id]; }
+	unsigned int Find(const std::string& name) const;
+
+	inline bool IsBuilt() const { return m_Built; }
+	inline unsigned int GetRegionCount() const { return (unsigned int)m_Regions.size(); }
+	inline unsigned int GetPageCount() const { return (unsigned int)m_Pages.size(); }
+	inline const Texture& GetPage(unsigned int index) const { return *m_Pages[index]; }
+
+private:
+	unsigned int AddImage(const std::string& name, Image&& image);
+	void CopyImage(const Image& image, std::vector<unsigned char>& page, int pageWidth, int x, int y) const;
+};
@@ -0,0 +1,305 @@
+#include "TextureFile.h"
+#include "GL/glew.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+    const unsigned char Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    // The file layout has no padding before the 64 bit fields
+#pragma pack(push, 1)
+    struct Ktx2Header
+    {
+        uint32_t VkFormat;
+        uint32_t TypeSize;
+        uint32_t PixelWidth, PixelHeight, PixelDepth;
+        uint32_t LayerCount, FaceCount, LevelCount;
+        uint32_t SupercompressionScheme;
+        uint32_t DfdByteOffset, DfdByteLength;
+        uint32_t KvdByteOffset, KvdByteLength;
+        uint64_t SgdByteOffset, SgdByteLength;
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Ktx2Header) == 68, "KTX2 header must match the file layout");
+
+    struct Ktx2Level
+    {
+        uint64_t ByteOffset, ByteLength, UncompressedByteLength;
+    };
+
+    struct DdsPixelFormat
+    {
+        uint32_t Size, Flags, FourCC, RGBBitCount;
+        uint32_t RBitMask, GBitMask, BBitMask, ABitMask;
+    };
+
+    struct DdsHeader
+    {
+        uint32_t Size, Flags, Height, Width, PitchOrLinearSize, Depth, MipMapCount;
+        uint32_t Reserved1[11];
+        DdsPixelFormat PixelFormat;
+        uint32_t Caps, Caps2, Caps3, Caps4, Reserved2;
+    };
+
+    struct DdsHeaderDx10
+    {
+        uint32_t DxgiFormat, ResourceDimension, MiscFlag, ArraySize, MiscFlags2;
+    };
+
+    const uint32_t DdsFourCCFlag = 0x4;
+
+    constexpr uint32_t FourCC(char a, char b, char c, char d)
+    {
+        return (uint32_t)(unsigned char)a | ((uint32_t)(unsigned char)b << 8) |
+            ((uint32_t)(unsigned char)c << 16) | ((uint32_t)(unsigned char)d << 24);
+    }
+
+    // The renderer doesn't do sRGB yet, so sRGB files are sampled like the RGBA8 path
+    // samples PNGs: raw values, no decode. Each table maps both variants to UNORM.
+    struct FormatMapping
+    {
+        uint32_t Source;
+        unsigned int Format;
+    };
+
+    const FormatMapping s_VkFormats[] =
+    {
+        { 37,  GL_RGBA8 },                                    // R8G8B8A8_UNORM
+        { 43,  GL_RGBA8 },                                    // R8G8B8A8_SRGB
+        { 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT },             // BC1_RGB_UNORM
+        { 132, GL_COMPRESSED_RGB_S3TC_DXT1_EXT },             // BC1_RGB_SRGB
+        { 133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT },            // BC1_RGBA_UNORM
+        { 134, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT },            // BC1_RGBA_SRGB
+        { 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT },            // BC3_UNORM
+        { 138, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT },            // BC3_SRGB
+        { 145, GL_COMPRESSED_RGBA_BPTC_UNORM },               // BC7_UNORM
+        { 146, GL_COMPRESSED_RGBA_BPTC_UNORM },               // BC7_SRGB
+        { 147, GL_COMPRESSED_RGB8_ETC2 },                     // ETC2_R8G8B8_UNORM
+        { 148, GL_COMPRESSED_RGB8_ETC2 },                     // ETC2_R8G8B8_SRGB
+        { 149, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 }, // ETC2_R8G8B8A1_UNORM
+        { 150, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 }, // ETC2_R8G8B8A1_SRGB
+        { 151, GL_COMPRESSED_RGBA8_ETC2_EAC },                // ETC2_R8G8B8A8_UNORM
+        { 152, GL_COMPRESSED_RGBA8_ETC2_EAC },                // ETC2_R8G8B8A8_SRGB
+    };
+
+    const FormatMapping s_DxgiFormats[] =
+    {
+        { 28, GL_RGBA8 },                         // R8G8B8A8_UNORM
+        { 29, GL_RGBA8 },                         // R8G8B8A8_UNORM_SRGB
+        { 71, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT }, // BC1_UNORM
+        { 72, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT }, // BC1_UNORM_SRGB
+        { 77, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT }, // BC3_UNORM
+        { 78, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT }, // BC3_UNORM_SRGB
+        { 98, GL_COMPRESSED_RGBA_BPTC_UNORM },    // BC7_UNORM
+        { 99, GL_COMPRESSED_RGBA_BPTC_UNORM },    // BC7_UNORM_SRGB
+    };
+
+    template<size_t N>
+    unsigned int MapFormat(const FormatMapping (&table)[N], uint32_t source)
+    {
+        for (const FormatMapping& mapping : table)
+            if (mapping.Source == source)
+                return mapping.Format;
+        return 0;
+    }
+
+    bool HasExtension(const std::string& path, const char* extension)
+    {
+        size_t length = strlen(extension);
+        if (path.size() < length)
+            return false;
+        return std::equal(path.end() - length, path.end(), extension,
+            [](char a, char b) { return tolower((unsigned char)a) == b; });
+    }
+
+}
+
+TextureFile::TextureFile(const std::string& path)
+    : m_File(new MappedFile(path)), m_Format(0), m_Compressed(false)
+{
+    if (!m_File->IsOpen())
+        Fail("can't open " + path);
+    else if (HasExtension(path, ".ktx2"))
+        ParseKtx2();
+    else if (HasExtension(path, ".dds"))
+        ParseDds();
+    else
+        Fail(path + " isn't a .ktx2 or .dds file");
+}
+
+void TextureFile::Prefault() const
+{
+    // One read per page is enough, volatile so the loop isn't optimized away
+    const size_t pageSize = 4096;
+    volatile unsigned char sink = 0;
+    for (const Level& level : m_Levels)
+    {
+        for (size_t offset = 0; offset < level.Size; offset += pageSize)
+            sink += level.Data[offset];
+        if (level.Size)
+            sink += level.Data[level.Size - 1];
+    }
+}
+
+bool TextureFile::IsTextureFile(const std::string& path)
+{
+    return HasExtension(path, ".ktx2") || HasExtension(path, ".dds");
+}
+
+bool TextureFile::IsFormatSupported(unsigned int format)
+{
+    switch (format)
+    {
+        case GL_RGBA8:
+            return true;
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            return GLEW_EXT_texture_compression_s3tc != 0;
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+            return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+            // Desktop drivers often decompress these on upload, they still save disk space
+            return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+    }
+    return false;
+}
+
+unsigned int TextureFile::GetBlockSize(unsigned int format)
+{
+    switch (format)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+            return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+            return 16;
+    }
+    return 0;
+}
+
+size_t TextureFile::GetLevelSize(unsigned int format, int width, int height)
+{
+    unsigned int blockSize = GetBlockSize(format);
+    if (blockSize)
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+    return (size_t)width * height * 4;
+}
+
+bool TextureFile::Fail(const std::string& error)
+{
+    m_Error = error;
+    m_Levels.clear();
+    return false;
+}
+
+bool TextureFile::ParseKtx2()
+{
+    const unsigned char* data = (const unsigned char*)m_File->GetData();
+    size_t size = m_File->GetSize();
+
+    if (size < sizeof(Ktx2Identifier) + sizeof(Ktx2Header) || memcmp(data, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0)
+        return Fail("not a KTX2 file");
+
+    Ktx2Header header;
+    memcpy(&header, data + sizeof(Ktx2Identifier), sizeof(header));
+
+    if (header.SupercompressionScheme != 0)
+        return Fail("supercompressed KTX2 isn't supported");
+    if (header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1)
+        return Fail("only 2D KTX2 textures are supported");
+
+    m_Format = MapFormat(s_VkFormats, header.VkFormat);
+    if (!m_Format)
+        return Fail("unsupported KTX2 vkFormat " + std::to_string(header.VkFormat));
+    m_Compressed = GetBlockSize(m_Format) != 0;
+
+    // Zero levels asks the loader to generate them, there's still exactly one stored
+    uint32_t levelCount = std::max(header.LevelCount, 1u);
+    size_t indexOffset = sizeof(Ktx2Identifier) + sizeof(Ktx2Header);
+    if (indexOffset + levelCount * sizeof(Ktx2Level) > size)
+        return Fail("truncated KTX2 level index");
+
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        Ktx2Level level;
+        memcpy(&level, data + indexOffset + i * sizeof(Ktx2Level), sizeof(level));
+
+        int width = std::max((int)header.PixelWidth >> i, 1);
+        int height = std::max((int)header.PixelHeight >> i, 1);
+        if (level.ByteOffset + level.ByteLength > size || level.ByteLength < GetLevelSize(m_Format, width, height))
+            return Fail("truncated KTX2 level " + std::to_string(i));
+
+        m_Levels.push_back({ width, height, data + level.ByteOffset, GetLevelSize(m_Format, width, height) });
+    }
+    return true;
+}
+
+bool TextureFile::ParseDds()
+{
+    const unsigned char* data = (const unsigned char*)m_File->GetData();
+    size_t size = m_File->GetSize();
+
+    if (size < 4 + sizeof(DdsHeader) || memcmp(data, "DDS ", 4) != 0)
+        return Fail("not a DDS file");
+
+    DdsHeader header;
+    memcpy(&header, data + 4, sizeof(header));
+    size_t offset = 4 + sizeof(DdsHeader);
+
+    if (!(header.PixelFormat.Flags & DdsFourCCFlag))
+    {
+        // Uncompressed, only 32 bit RGBA in byte order is taken as is
+        if (header.PixelFormat.RGBBitCount != 32 || header.PixelFormat.RBitMask != 0x000000FF ||
+            header.PixelFormat.GBitMask != 0x0000FF00 || header.PixelFormat.BBitMask != 0x00FF0000)
+            return Fail("unsupported uncompressed DDS layout");
+        m_Format = GL_RGBA8;
+    }
+    else if (header.PixelFormat.FourCC == FourCC('D', 'X', '1', '0'))
+    {
+        if (size < offset + sizeof(DdsHeaderDx10))
+            return Fail("truncated DDS DX10 header");
+
+        DdsHeaderDx10 dx10;
+        memcpy(&dx10, data + offset, sizeof(dx10));
+        offset += sizeof(DdsHeaderDx10);
+
+        if (dx10.ArraySize > 1)
+            return Fail("DDS arrays aren't supported");
+        m_Format = MapFormat(s_DxgiFormats, dx10.DxgiFormat);
+        if (!m_Format)
+            return Fail("unsupported DXGI format " + std::to_string(dx10.DxgiFormat));
+    }
+    else if (header.PixelFormat.FourCC == FourCC('D', 'X', 'T', '1'))
+        m_Format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    else if (header.PixelFormat.FourCC == FourCC('D', 'X', 'T', '5'))
+        m_Format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    else
+        return Fail("unsupported DDS FourCC");
+
+    m_Compressed = GetBlockSize(m_Format) != 0;
+
+    // Levels follow each other with no padding
+    uint32_t levelCount = std::max(header.MipMapCount, 1u);
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        int width = std::max((int)header.Width >> i, 1);
+        int height = std::max((int)header.Height >> i, 1);
+        size_t levelSize = GetLevelSize(m_Format, width, height);
+        if (offset + levelSize > size)
+            return Fail("truncated DDS level " + std::to_string(i));
+
+        m_Levels.push_back({ width, height, data + offset, levelSize });
+        offset += levelSize;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// A texture file that's already in its GPU format, KTX2 or DDS, holding BC1/BC3/BC7,
+// ETC2 or plain RGBA8 with its mip chain. The file is mapped and the levels point
+// into it, so uploading is the only copy. Supercompressed KTX2 (Basis, zstd) and
+// cube maps or arrays aren't supported.
+//
+// Both formats store the top row first. This is uploaded as is, so files should be
+// flipped when they're made like stbi_set_flip_vertically_on_load(1) would.
+class TextureFile
+{
+public:
+	struct Level
+	{
+		int Width, Height;
+		const unsigned char* Data;
+		size_t Size;
+	};
+
+private:
+	std::unique_ptr<MappedFile> m_File;
+	unsigned int m_Format; // GL internal format
+	bool m_Compressed;
+	std::vector<Level> m_Levels;
+	std::string m_Error;
+
+public:
+	TextureFile(const std::string& path);
+
+	inline bool IsValid() const { return m_Error.empty(); }
+	inline const std::string& GetError() const { return m_Error; }
+
+	inline unsigned int GetFormat() const { return m_Format; }
+	inline bool IsCompressed() const { return m_Compressed; }
+	inline const std::vector<Level>& GetLevels() const { return m_Levels; }
+	inline int GetWidth() const { return m_Levels.empty() ? 0 : m_Levels[0].Width; }
+	inline int GetHeight() const { return m_Levels.empty() ? 0 : m_Levels[0].Height; }
+
+	// Touches every page of the level data so it's read in now, on the calling thread
+	void Prefault() const;
+
+	// By extension, .ktx2 and .dds
+	static bool IsTextureFile(const std::string& path);
+	// Whether the driver can sample this internal format
+	static bool IsFormatSupported(unsigned int format);
+	// Bytes per 4x4 block for compressed formats, 0 for anything else
+	static unsigned int GetBlockSize(unsigned int format);
+	static size_t GetLevelSize(unsigned int format, int width, int height);
+
+private:
+	bool ParseKtx2();
+	bool ParseDds();
+	bool Fail(const std::string& error);
+};
@@ -0,0 +1,104 @@
+#include "TextureLibrary.h"
+#include "TextureLoader.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+TextureLibrary::TextureLibrary(TextureLoader* loader, size_t budget)
+    : m_Loader(loader), m_Budget(budget), m_Clock(0)
+{
+}
+
+std::string TextureLibrary::CanonicalPath(const std::string& path)
+{
+    std::string canonical = path;
+#ifdef _MSC_VER
+    char buffer[_MAX_PATH];
+    if (_fullpath(buffer, path.c_str(), sizeof(buffer)))
+        canonical = buffer;
+
+    // Windows paths are case insensitive and take either slash
+    std::transform(canonical.begin(), canonical.end(), canonical.begin(), [](char c) { return c == '\\' ? '/' : (char)tolower((unsigned char)c); });
+#else
+    // Also resolves symlinks, but only for files that exist
+    if (char* resolved = realpath(path.c_str(), nullptr))
+    {
+        canonical = resolved;
+        free(resolved);
+    }
+#endif
+    return canonical;
+}
+
+uint64_t TextureLibrary::HashSpec(const TextureSpec& spec)
+{
+    // Field by field, the struct has padding
+    uint64_t hash = Fnv1a64(&spec.Mipmaps, sizeof(spec.Mipmaps));
+    hash = Fnv1a64(&spec.Trilinear, sizeof(spec.Trilinear), hash);
+    hash = Fnv1a64(&spec.Anisotropy, sizeof(spec.Anisotropy), hash);
+    return Fnv1a64(&spec.Wrap, sizeof(spec.Wrap), hash);
+}
+
+std::shared_ptr<Texture> TextureLibrary::Get(const std::string& path, const TextureSpec& spec)
+{
+    m_Clock++;
+
+    std::string key = CanonicalPath(path) + '\n' + std::to_string(HashSpec(spec));
+    auto entry = m_Entries.find(key);
+    if (entry != m_Entries.end())
+    {
+        entry->second.LastUsed = m_Clock;
+        m_Stats.Hits++;
+        return entry->second.Handle;
+    }
+
+    std::shared_ptr<Texture> texture = m_Loader ? m_Loader->Load(path, spec) : std::make_shared<Texture>(path, spec);
+    m_Entries[key] = { texture, m_Clock };
+    m_Stats.Loads++;
+
+    // The new texture is held by 'texture' here, so it's never the one evicted
+    Trim();
+    return texture;
+}
+
+size_t TextureLibrary::GetMemoryUsage() const
+{
+    size_t usage = 0;
+    for (const auto& entry : m_Entries)
+        usage += entry.second.Handle->GetMemorySize();
+    return usage;
+}
+
+unsigned int TextureLibrary::Trim()
+{
+    size_t usage = GetMemoryUsage();
+    if (usage <= m_Budget)
+        return 0;
+
+    // Only the library holds these, oldest first
+    std::vector<std::pair<uint64_t, std::string>> candidates; // Last used, key
+    for (const auto& entry : m_Entries)
+    {
+        if (entry.second.Handle.use_count() == 1)
+            candidates.push_back({ entry.second.LastUsed, entry.first });
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    unsigned int evicted = 0;
+    for (const auto& candidate : candidates)
+    {
+        if (usage <= m_Budget)
+            break;
+
+        auto entry = m_Entries.find(candidate.second);
+        usage -= entry->second.Handle->GetMemorySize();
+        m_Entries.erase(entry);
+        evicted++;
+    }
+
+    m_Stats.Evictions += evicted;
+    return evicted;
+}
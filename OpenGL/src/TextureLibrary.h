@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Texture.h"
+
+class TextureLoader;
+
+// Hands out one shared Texture per image and spec. Paths are canonicalized, so
+// "./a.png" and "a.png" share one GL object. With a loader an identical copy under
+// another name shares it too, the loader spots those while decoding. Textures
+// nothing else holds on to are kept around until the budget runs out, then dropped
+// least recently used first.
+class TextureLibrary
+{
+public:
+	struct Stats
+	{
+		unsigned int Hits = 0; // Path seen before
+		unsigned int Loads = 0;
+		unsigned int Evictions = 0;
+	};
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<Texture> Handle;
+		uint64_t LastUsed;
+	};
+
+	TextureLoader* m_Loader;
+	size_t m_Budget;
+	uint64_t m_Clock;
+
+	std::unordered_map<std::string, Entry> m_Entries; // By canonical path and spec
+
+	Stats m_Stats;
+
+public:
+	// With a loader textures load asynchronously, see TextureLoader. The budget is in
+	// bytes of video memory and only limits textures the library is the last owner of.
+	TextureLibrary(TextureLoader* loader = nullptr, size_t budget = 256 * 1024 * 1024);
+
+	TextureLibrary(const TextureLibrary&) = delete;
+	TextureLibrary& operator=(const TextureLibrary&) = delete;
+
+	std::shared_ptr<Texture> Get(const std::string& path, const TextureSpec& spec = TextureSpec());
+
+	// Evicts unused textures until the library fits its budget, returns how many went.
+	// Get() does this too, call it every frame so async textures count once uploaded.
+	unsigned int Trim();
+
+	inline void SetBudget(size_t bytes) { m_Budget = bytes; }
+	inline size_t GetBudget() const { return m_Budget; }
+	size_t GetMemoryUsage() const;
+	inline size_t GetCount() const { return m_Entries.size(); }
+	inline const Stats& GetStats() const { return m_Stats; }
+
+	static std::string CanonicalPath(const std::string& path);
+
+private:
+	static uint64_t HashSpec(const TextureSpec& spec);
+};
@@ -0,0 +1,218 @@
+#include "TextureLoader.h"
+#include "MappedFile.h"
+#include "Hash.h"
+#include "stb_image/stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Transparent, so nothing pops in as a grey box while its image loads
+static const unsigned char s_PlaceholderPixel[4] = { 0, 0, 0, 0 };
+
+TextureLoader::TextureLoader(unsigned int threadCount)
+    : m_Stopping(false), m_Pending(0), m_Deduplicated(0), m_Placeholder(1, 1, s_PlaceholderPixel)
+{
+    if (threadCount == 0)
+    {
+        // Leave a core for the render thread
+        unsigned int hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_Workers.emplace_back(&TextureLoader::WorkerLoop, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Wake.notify_all();
+
+    for (std::thread& worker : m_Workers)
+        worker.join();
+
+    // Whatever was decoded but never uploaded
+    for (Job& job : m_Decoded)
+        stbi_image_free(job.Pixels);
+}
+
+std::shared_ptr<Texture> TextureLoader::Load(const std::string& path, const TextureSpec& spec)
+{
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>(&m_Placeholder, spec);
+    texture->m_FilePath = path;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queued.push_back({ texture, path, spec, nullptr, {}, 0, 0, nullptr, "", nullptr });
+        m_Pending++;
+    }
+    m_Wake.notify_one();
+
+    return texture;
+}
+
+void TextureLoader::WorkerLoop()
+{
+    // The global flip flag isn't safe to share between threads
+    stbi_set_flip_vertically_on_load_thread(1);
+
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this] { return m_Stopping || !m_Queued.empty(); });
+            if (m_Stopping)
+                return;
+
+            job = std::move(m_Queued.front());
+            m_Queued.pop_front();
+        }
+
+        // Nobody wants it anymore, don't bother decoding
+        if (!job.Target.expired() && !FindDuplicate(job))
+            Decode(job);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Decoded.push_back(std::move(job));
+    }
+}
+
+bool TextureLoader::FindDuplicate(Job& job)
+{
+    // Missing files fail in Decode with a proper error
+    MappedFile file(job.Path);
+    if (!file.IsOpen())
+        return false;
+    uint64_t hash = Fnv1a64(file.GetData(), file.GetSize());
+
+    std::vector<Content> candidates;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto range = m_Contents.equal_range(hash);
+        for (auto it = range.first; it != range.second; )
+        {
+            if (it->second.Target.expired())
+            {
+                it = m_Contents.erase(it);
+                continue;
+            }
+            if (it->second.Size == file.GetSize() && it->second.Spec == job.Spec)
+                candidates.push_back(it->second);
+            ++it;
+        }
+    }
+
+    // The hash only narrows it down, the bytes decide. The other file may also
+    // have changed on disk since it was loaded.
+    for (const Content& candidate : candidates)
+    {
+        MappedFile other(candidate.Path);
+        if (!other.IsOpen() || other.GetSize() != file.GetSize() || memcmp(other.GetData(), file.GetData(), file.GetSize()) != 0)
+            continue;
+
+        job.Source = candidate.Target.lock();
+        if (job.Source)
+            return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Contents.insert({ hash, { job.Target, job.Path, file.GetSize(), job.Spec } });
+    return false;
+}
+
+void TextureLoader::Decode(Job& job)
+{
+    if (TextureFile::IsTextureFile(job.Path))
+    {
+        // Already in GPU format, mapping, parsing and reading the pages in is all there is to
+        // do. Left to the upload, the page faults would hit the disk on the render thread.
+        job.File.reset(new TextureFile(job.Path));
+        if (!job.File->IsValid())
+            job.Error = job.File->GetError();
+        else
+            job.File->Prefault();
+        return;
+    }
+
+    int bpp;
+    job.Pixels = stbi_load(job.Path.c_str(), &job.Width, &job.Height, &bpp, 4);
+    if (!job.Pixels)
+        job.Error = stbi_failure_reason();
+    else if (job.Spec.Mipmaps == TextureMipmaps::Box || job.Spec.Mipmaps == TextureMipmaps::Kaiser)
+        job.Mips = GenerateMipChain(job.Pixels, job.Width, job.Height,
+            job.Spec.Mipmaps == TextureMipmaps::Box ? MipFilter::Box : MipFilter::Kaiser);
+}
+
+unsigned int TextureLoader::Update(double budgetMilliseconds)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    unsigned int uploaded = 0;
+    for (;;)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Decoded.empty())
+                break;
+            job = std::move(m_Decoded.front());
+            m_Decoded.pop_front();
+        }
+        m_Pending--;
+
+        std::shared_ptr<Texture> texture = job.Target.lock();
+        if (job.Source)
+        {
+            // Nothing to upload, fine if the source is still loading itself
+            if (texture)
+            {
+                texture->Share(job.Source);
+                m_Deduplicated++;
+            }
+            continue;
+        }
+
+        if (job.File && job.File->IsValid())
+        {
+            // Goes straight from the mapping into glCompressedTexImage2D
+            if (texture)
+            {
+                texture->Create(*job.File);
+                uploaded++;
+            }
+        }
+        else if (!job.Pixels)
+        {
+            if (texture)
+                std::cout << "Failed to load texture " << job.Path << ": " << job.Error << std::endl;
+            continue;
+        }
+        else
+        {
+            if (texture)
+            {
+                // Allocate, then stream the pixels in through the ring instead of a blocking copy
+                texture->Create(job.Width, job.Height, nullptr);
+                m_UploadRing.Upload(*texture, 0, 0, job.Width, job.Height, job.Pixels);
+
+                for (size_t i = 0; i < job.Mips.size(); i++)
+                    m_UploadRing.Upload(*texture, 0, 0, job.Mips[i].Width, job.Mips[i].Height, job.Mips[i].Pixels.data(), (int)i + 1);
+                if (job.Spec.Mipmaps == TextureMipmaps::GPU)
+                    texture->GenerateMipmaps();
+                uploaded++;
+            }
+            stbi_image_free(job.Pixels);
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        if (elapsed.count() >= budgetMilliseconds)
+            break;
+    }
+    return uploaded;
+}
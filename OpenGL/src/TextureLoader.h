@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Texture.h"
+#include "PixelBufferRing.h"
+#include "Mipmap.h"
+#include "TextureFile.h"
+
+// Decodes images on worker threads and uploads them on the render thread a few
+// at a time, so loading hundreds of textures never stalls a frame. Textures bind
+// the placeholder until their upload has happened.
+//
+// Workers also hash each file, and one that's byte for byte the same as a file
+// already loaded with the same spec isn't decoded at all, its texture shares the
+// other one's image instead.
+class TextureLoader
+{
+private:
+	struct Job
+	{
+		std::weak_ptr<Texture> Target; // Dropped textures are skipped
+		std::string Path;
+		TextureSpec Spec;
+		unsigned char* Pixels;
+		std::vector<MipLevel> Mips; // CPU filtered levels, built on the worker too
+		int Width, Height;
+		std::unique_ptr<TextureFile> File; // .ktx2 and .dds, mapped and parsed but not decoded
+		std::string Error; // stb's failure reason is per thread, so it travels with the job
+		std::shared_ptr<Texture> Source; // Identical file already loaded, nothing else is set
+	};
+
+	struct Content
+	{
+		std::weak_ptr<Texture> Target;
+		std::string Path;
+		size_t Size;
+		TextureSpec Spec;
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::deque<Job> m_Queued;  // Waiting for a worker
+	std::deque<Job> m_Decoded; // Waiting for the render thread
+	bool m_Stopping;
+	std::atomic<unsigned int> m_Pending;
+	std::unordered_multimap<uint64_t, Content> m_Contents; // By hash of the file, under m_Mutex
+	unsigned int m_Deduplicated;
+
+	Texture m_Placeholder;
+	PixelBufferRing m_UploadRing;
+
+public:
+	// Zero threads picks one less than the hardware has, but at least one
+	TextureLoader(unsigned int threadCount = 0);
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	// Returns right away, the texture binds the placeholder until it's uploaded
+	std::shared_ptr<Texture> Load(const std::string& path, const TextureSpec& spec = TextureSpec());
+
+	// Call once per frame on the render thread. Uploads decoded images until the
+	// budget is used up, at least one per call so loading always moves forward.
+	// Returns how many were uploaded.
+	unsigned int Update(double budgetMilliseconds = 2.0);
+
+	inline const Texture& GetPlaceholder() const { return m_Placeholder; }
+	inline const PixelBufferRing& GetUploadRing() const { return m_UploadRing; }
+	// Queued, decoding or waiting for upload
+	inline unsigned int GetPendingCount() const { return m_Pending.load(std::memory_order_relaxed); }
+	// Loads that turned out to be a copy of a file already loaded
+	inline unsigned int GetDeduplicatedCount() const { return m_Deduplicated; }
+
+private:
+	void WorkerLoop();
+	// Hashes the file and compares it against earlier files with the same hash, size
+	// and spec. Fills in job.Source on a match, otherwise remembers the file.
+	bool FindDuplicate(Job& job);
+	static void Decode(Job& job);
+};
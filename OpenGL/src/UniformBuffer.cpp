@@ -0,0 +1,41 @@
+#include "UniformBuffer.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "GPUMemory.h"
+
+UniformBuffer::UniformBuffer(unsigned int size, unsigned int binding)
+    : m_Size(size), m_Binding(binding)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+    GPUMemory::Allocate(this, GPUMemoryCategory::UniformBuffer, size, m_RendererID);
+
+    // Also binds the generic GL_UNIFORM_BUFFER target, which the cache already has
+    GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GPUMemory::Free(this);
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= m_Size);
+
+    Bind();
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+void UniformBuffer::Bind() const
+{
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+}
+
+void UniformBuffer::Unbind() const
+{
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+
+// A buffer of uniform block data, attached to a binding point that
+// shaders connect their blocks to with Shader::SetUniformBlockBinding
+class UniformBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+	unsigned int m_Binding;
+
+public:
+	UniformBuffer(unsigned int size, unsigned int binding);
+	~UniformBuffer();
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetBinding() const { return m_Binding; }
+	inline unsigned int GetSize() const { return m_Size; }
+};
@@ -1,42 +1,73 @@
 #include "VertexArray.h"
 #include "Renderer.h"
 #include "VertexBufferLayout.h"
+#include "GLState.h"
+#include "RingBuffer.h"
+#include "GPUMemory.h"
 
 VertexArray::VertexArray()
+	: m_AttribCount(0)
 {
 	GLCall(glGenVertexArrays(1, &m_RendererID));
-	GLCall(glBindVertexArray(m_RendererID));
+	GLState::BindVertexArray(m_RendererID);
+	GPUMemory::Allocate(this, GPUMemoryCategory::VertexArray, 0, m_RendererID);
 }
 
 VertexArray::~VertexArray()
 {
+	GPUMemory::Free(this);
 	GLCall(glDeleteVertexArrays(1, &m_RendererID));
+	GLState::OnVertexArrayDeleted(m_RendererID);
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
 {
 	Bind();
 	vb.Bind();
+	AddAttributes(layout);
+}
+
+void VertexArray::AddBuffer(const RingBuffer& rb, const VertexBufferLayout& layout)
+{
+	Bind();
+	rb.Bind();
+	AddAttributes(layout);
+}
+
+void VertexArray::AddAttributes(const VertexBufferLayout& layout)
+{
 	const auto& elements = layout.GetElements();
 	unsigned int offset = 0;
 	for (unsigned int i = 0; i < elements.size(); i++)
 	{
 		const auto& element = elements[i];
-		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)offset));
-		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
-	}
+		unsigned int typeSize = VertexBufferElement::GetSizeOfType(element.type);
+
+		// Attributes hold at most 4 components, so a mat4 (16 floats) takes 4 consecutive locations
+		for (unsigned int column = 0; column < element.count; column += 4)
+		{
+			unsigned int count = element.count - column < 4 ? element.count - column : 4;
 
-	
+			GLCall(glEnableVertexAttribArray(m_AttribCount));
+			GLCall(glVertexAttribPointer(m_AttribCount, count, element.type, element.normalized, layout.GetStride(), (const void*)(uintptr_t)(offset + column * typeSize)));
+			if (layout.GetDivisor())
+			{
+				GLCall(glVertexAttribDivisor(m_AttribCount, layout.GetDivisor()));
+			}
+
+			m_AttribCount++;
+		}
+		offset += element.count * typeSize;
+	}
 }
 
 void VertexArray::Bind() const
 {
-	GLCall(glBindVertexArray(m_RendererID));
+	GLState::BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-	GLCall(glBindVertexArray(0));
+	GLState::BindVertexArray(0);
 }
 
@@ -3,17 +3,27 @@
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
+class RingBuffer;
 
 class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_AttribCount;
 public:
 	VertexArray();
 	~VertexArray();
 
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// Attributes start at offset 0 of the ring, draw with a base vertex to pick the allocation
+	void AddBuffer(const RingBuffer& rb, const VertexBufferLayout& layout);
 
 	void Bind() const;
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+private:
+	// Points the next locations at the bound GL_ARRAY_BUFFER
+	void AddAttributes(const VertexBufferLayout& layout);
 };
\ No newline at end of file
@@ -1,26 +1,74 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "GPUMemory.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+static GLenum ToGLUsage(BufferUsage usage)
+{
+    switch (usage)
+    {
+        case BufferUsage::Dynamic: return GL_DYNAMIC_DRAW;
+        case BufferUsage::Stream:  return GL_STREAM_DRAW;
+        default:                   return GL_STATIC_DRAW;
+    }
+}
+
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, BufferUsage usage)
+    : m_Size(size), m_Usage(usage)
 {
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, ToGLUsage(m_Usage)));
+    GPUMemory::Allocate(this, GPUMemoryCategory::VertexBuffer, size, m_RendererID);
 
     // Shouldn't we unbind?
 }
 
 VertexBuffer::~VertexBuffer()
 {
+    GPUMemory::Free(this);
     GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
+}
+
+void VertexBuffer::SetData(unsigned int offset, const void* data, unsigned int size)
+{
+    ASSERT(offset + size <= m_Size);
+
+    Bind();
+    if (offset == 0 && size == m_Size)
+    {
+        // Same size and usage, so this only swaps the storage underneath
+        GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, data, ToGLUsage(m_Usage)));
+    }
+    else
+    {
+        GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+    }
+}
+
+void VertexBuffer::Stream(const void* data, unsigned int size)
+{
+    ASSERT(size <= m_Size);
+
+    Bind();
+    if (size == m_Size)
+    {
+        GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, data, ToGLUsage(m_Usage)));
+    }
+    else
+    {
+        GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, ToGLUsage(m_Usage)));
+        GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+    }
 }
 
 void VertexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 }
 
 void VertexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
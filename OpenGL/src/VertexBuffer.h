@@ -1,15 +1,37 @@
 #pragma once
 
 
+// How often the contents change, picks the GL usage hint
+enum class BufferUsage
+{
+	Static,  // Written once, GL_STATIC_DRAW
+	Dynamic, // Updated now and then, drawn many times in between, GL_DYNAMIC_DRAW
+	Stream   // Rewritten for about every draw, GL_STREAM_DRAW
+};
+
+// Owns its storage, for geometry that outlives a frame. Vertices rebuilt every frame are
+// better off in Renderer::AllocateTransientVertices, Stream is the fallback without it.
 class VertexBuffer
 {
 private: 
 	unsigned int m_RendererID;
+	unsigned int m_Size;
+	BufferUsage m_Usage;
 
 public:
-	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(const void* data, unsigned int size, BufferUsage usage = BufferUsage::Static);
 	~VertexBuffer();
 
+	// Replaces 'size' bytes at 'offset'. Writing the whole buffer orphans it, so the driver
+	// hands out fresh storage instead of waiting for draws still reading the old contents.
+	void SetData(unsigned int offset, const void* data, unsigned int size);
+	// Orphans the buffer and writes 'size' bytes at the start, for contents rebuilt every
+	// use where everything past 'size' is dead anyway
+	void Stream(const void* data, unsigned int size);
+
 	void Bind() const;
 	void Unbind() const;
-};
\ No newline at end of file
+
+	inline unsigned int GetSize() const { return m_Size; }
+	inline BufferUsage GetUsage() const { return m_Usage; }
+};
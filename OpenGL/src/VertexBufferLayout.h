@@ -29,10 +29,14 @@ class VertexBufferLayout
 private:
 	std::vector<VertexBufferElement> m_Elements;
 	unsigned int m_Stride;
+	unsigned int m_Divisor;
 
 public: 
 	VertexBufferLayout()
-		: m_Stride(0) {}
+		: m_Stride(0), m_Divisor(0) {}
+
+	// A divisor of N advances the buffer once every N instances instead of once per vertex
+	void SetDivisor(unsigned int divisor) { m_Divisor = divisor; }
 
 	template<typename T>
 	void Push(unsigned int count)
@@ -64,4 +68,5 @@ public:
 
 	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
+	inline unsigned int GetDivisor() const { return m_Divisor; }
 };
\ No newline at end of file
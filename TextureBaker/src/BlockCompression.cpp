@@ -0,0 +1,191 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+    uint16_t To565(const float color[3])
+    {
+        int r = std::min(std::max((int)(color[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+        int g = std::min(std::max((int)(color[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+        int b = std::min(std::max((int)(color[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void From565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // Endpoints are the extreme texels along the principal axis of the block's colors
+    void EncodeColor(const unsigned char* texels, unsigned char* out)
+    {
+        float mean[3] = {};
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+                mean[c] += texels[i * 4 + c] / 16.0f;
+
+        float covariance[6] = {}; // rr rg rb gg gb bb
+        for (int i = 0; i < 16; i++)
+        {
+            float d[3] = { texels[i * 4] - mean[0], texels[i * 4 + 1] - mean[1], texels[i * 4 + 2] - mean[2] };
+            covariance[0] += d[0] * d[0]; covariance[1] += d[0] * d[1]; covariance[2] += d[0] * d[2];
+            covariance[3] += d[1] * d[1]; covariance[4] += d[1] * d[2]; covariance[5] += d[2] * d[2];
+        }
+
+        // A few power iterations are plenty for a 3x3 matrix
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[3] =
+            {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2],
+            };
+            float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < 3; c++)
+                axis[c] = next[c] / length;
+        }
+
+        float minProjection = 1e9f, maxProjection = -1e9f;
+        for (int i = 0; i < 16; i++)
+        {
+            float projection = (texels[i * 4] - mean[0]) * axis[0] + (texels[i * 4 + 1] - mean[1]) * axis[1] + (texels[i * 4 + 2] - mean[2]) * axis[2];
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        float high[3], low[3];
+        for (int c = 0; c < 3; c++)
+        {
+            high[c] = mean[c] + axis[c] * maxProjection;
+            low[c] = mean[c] + axis[c] * minProjection;
+        }
+
+        // The first endpoint must be larger, otherwise BC1 switches to its 3 color mode
+        uint16_t color0 = To565(high), color1 = To565(low);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][3];
+            From565(color0, palette[0]);
+            From565(color1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = INT32_MAX;
+                for (int p = 0; p < 4; p++)
+                {
+                    int distance = 0;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        int d = texels[i * 4 + c] - palette[p][c];
+                        distance += d * d;
+                    }
+                    if (distance < bestDistance)
+                    {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= (uint32_t)best << (i * 2);
+            }
+        }
+
+        // Little endian, like the GPU reads it
+        out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+        out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+
+    void EncodeAlpha(const unsigned char* texels, unsigned char* out)
+    {
+        int alpha0 = 0, alpha1 = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            alpha0 = std::max(alpha0, (int)texels[i * 4 + 3]);
+            alpha1 = std::min(alpha1, (int)texels[i * 4 + 3]);
+        }
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1)
+        {
+            // alpha0 > alpha1 selects 6 interpolated values between them
+            int palette[8] = { alpha0, alpha1 };
+            for (int p = 1; p < 7; p++)
+                palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = INT32_MAX;
+                for (int p = 0; p < 8; p++)
+                {
+                    int distance = std::abs(texels[i * 4 + 3] - palette[p]);
+                    if (distance < bestDistance)
+                    {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= (uint64_t)best << (i * 3);
+            }
+        }
+
+        out[0] = (unsigned char)alpha0;
+        out[1] = (unsigned char)alpha1;
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+
+}
+
+std::vector<unsigned char> CompressImage(const unsigned char* pixels, int width, int height, BlockFormat format)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockSize = format == BlockFormat::BC1 ? 8 : 16;
+    std::vector<unsigned char> result(blocksX * blocksY * blockSize);
+
+    unsigned char texels[16 * 4];
+    unsigned char* out = result.data();
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                for (int x = 0; x < 4; x++)
+                {
+                    int sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);
+                    memcpy(texels + (y * 4 + x) * 4, pixels + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+
+            if (format == BlockFormat::BC3)
+            {
+                EncodeAlpha(texels, out);
+                out += 8;
+            }
+            EncodeColor(texels, out);
+            out += 8;
+        }
+    }
+    return result;
+}
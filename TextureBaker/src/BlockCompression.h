@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+enum class BlockFormat
+{
+	BC1, // 8 bytes per 4x4 block, RGB only
+	BC3  // 16 bytes per 4x4 block, BC1 color plus interpolated alpha
+};
+
+// Compresses RGBA8 pixels into 4x4 blocks, rows of blocks in the same order as the
+// pixel rows. Edge blocks of sizes that aren't a multiple of 4 repeat the last texel.
+std::vector<unsigned char> CompressImage(const unsigned char* pixels, int width, int height, BlockFormat format);
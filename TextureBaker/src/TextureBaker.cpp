@@ -0,0 +1,295 @@
+// Bakes source images into KTX2 files that Texture loads with one mapping and a
+// direct upload: flipped like stbi_set_flip_vertically_on_load(1), with the full
+// mip chain, optionally block compressed.
+//
+//   TextureBaker <input> <output.ktx2> [--format rgba8|bc1|bc3] [--mips none|box|kaiser] [--no-flip]
+//
+// For example, from the OpenGL directory:
+//   TextureBaker res/textures/hk.png res/textures/hk.ktx2 --format bc3 --mips kaiser
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "stb_image/stb_image.h"
+#include "Mipmap.h"
+#include "BlockCompression.h"
+
+enum class OutputFormat
+{
+    RGBA8, BC1, BC3
+};
+
+struct Options
+{
+    std::string Input;
+    std::string Output;
+    OutputFormat Format = OutputFormat::RGBA8;
+    bool Mips = true;
+    MipFilter Filter = MipFilter::Box;
+    bool Flip = true;
+};
+
+// Per format values for the KTX2 header and its data format descriptor
+struct FormatInfo
+{
+    uint32_t VkFormat;
+    uint8_t ColorModel;       // KHR_DF_MODEL_*
+    uint8_t BlockDimension;   // Texel block size minus one
+    uint8_t BytesPerBlock;
+};
+
+static FormatInfo GetFormatInfo(OutputFormat format)
+{
+    switch (format)
+    {
+        case OutputFormat::BC1: return { 131, 128, 3, 8 };  // VK_FORMAT_BC1_RGB_UNORM_BLOCK, KHR_DF_MODEL_BC1A
+        case OutputFormat::BC3: return { 137, 130, 3, 16 }; // VK_FORMAT_BC3_UNORM_BLOCK, KHR_DF_MODEL_BC3
+        default:                return { 37, 1, 0, 4 };     // VK_FORMAT_R8G8B8A8_UNORM, KHR_DF_MODEL_RGBSDA
+    }
+}
+
+static void PrintUsage()
+{
+    std::cout << "Usage: TextureBaker <input> <output.ktx2> [--format rgba8|bc1|bc3] [--mips none|box|kaiser] [--no-flip]" << std::endl;
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options)
+{
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+
+        if (arg == "--format")
+        {
+            if (value == "rgba8")      options.Format = OutputFormat::RGBA8;
+            else if (value == "bc1")   options.Format = OutputFormat::BC1;
+            else if (value == "bc3")   options.Format = OutputFormat::BC3;
+            else return false;
+            i++;
+        }
+        else if (arg == "--mips")
+        {
+            if (value == "none")        options.Mips = false;
+            else if (value == "box")    options.Filter = MipFilter::Box;
+            else if (value == "kaiser") options.Filter = MipFilter::Kaiser;
+            else return false;
+            i++;
+        }
+        else if (arg == "--no-flip")
+        {
+            options.Flip = false;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 2)
+        return false;
+    options.Input = positional[0];
+    options.Output = positional[1];
+    return true;
+}
+
+static void Append32(std::vector<unsigned char>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back((value >> (i * 8)) & 0xFF);
+}
+
+static void Append64(std::vector<unsigned char>& out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        out.push_back((value >> (i * 8)) & 0xFF);
+}
+
+static void Pad(std::vector<unsigned char>& out, size_t alignment)
+{
+    while (out.size() % alignment)
+        out.push_back(0);
+}
+
+// Basic data format descriptor, KTX2 requires one even though Texture only reads vkFormat
+static std::vector<unsigned char> BuildDataFormatDescriptor(OutputFormat format)
+{
+    FormatInfo info = GetFormatInfo(format);
+
+    struct Sample
+    {
+        uint16_t BitOffset;
+        uint8_t BitLength; // Minus one
+        uint8_t Channel;
+        uint32_t Upper;
+    };
+    std::vector<Sample> samples;
+    if (format == OutputFormat::RGBA8)
+        samples = { { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, 15, 255 } };
+    else if (format == OutputFormat::BC1)
+        samples = { { 0, 63, 0, UINT32_MAX } };
+    else
+        samples = { { 0, 63, 15, UINT32_MAX }, { 64, 63, 0, UINT32_MAX } }; // Alpha block, then color block
+
+    uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+
+    std::vector<unsigned char> dfd;
+    Append32(dfd, 4 + blockSize); // Total size
+    Append32(dfd, 0);             // Vendor Khronos, descriptor type basic
+    Append32(dfd, 2 | (blockSize << 16)); // Version 1.3, block size
+    dfd.push_back(info.ColorModel);
+    dfd.push_back(1); // BT.709 primaries
+    dfd.push_back(1); // Linear transfer, to agree with the _UNORM vkFormat
+    dfd.push_back(0); // Straight alpha
+    for (int i = 0; i < 4; i++)
+        dfd.push_back(i < 2 ? info.BlockDimension : 0);
+    dfd.push_back(info.BytesPerBlock);
+    for (int i = 1; i < 8; i++)
+        dfd.push_back(0);
+
+    for (const Sample& sample : samples)
+    {
+        Append32(dfd, sample.BitOffset | (sample.BitLength << 16) | (sample.Channel << 24));
+        Append32(dfd, 0); // Sample position
+        Append32(dfd, 0); // Lower
+        Append32(dfd, sample.Upper);
+    }
+    return dfd;
+}
+
+static std::vector<unsigned char> BuildKeyValueData(bool flipped)
+{
+    // Rows going up match GL's bottom left origin
+    const std::pair<const char*, const char*> entries[] =
+    {
+        { "KTXorientation", flipped ? "ru" : "rd" },
+        { "KTXwriter", "TextureBaker" },
+    };
+
+    std::vector<unsigned char> kvd;
+    for (const auto& entry : entries)
+    {
+        size_t keyLength = strlen(entry.first) + 1, valueLength = strlen(entry.second) + 1;
+        Append32(kvd, (uint32_t)(keyLength + valueLength));
+        kvd.insert(kvd.end(), entry.first, entry.first + keyLength);
+        kvd.insert(kvd.end(), entry.second, entry.second + valueLength);
+        Pad(kvd, 4);
+    }
+    return kvd;
+}
+
+static bool WriteKtx2(const std::string& path, OutputFormat format, int width, int height,
+    const std::vector<std::vector<unsigned char>>& levels, bool flipped)
+{
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    FormatInfo info = GetFormatInfo(format);
+
+    std::vector<unsigned char> dfd = BuildDataFormatDescriptor(format);
+    std::vector<unsigned char> kvd = BuildKeyValueData(flipped);
+
+    // Identifier, header, index, then the level index
+    size_t levelIndexOffset = 12 + 36 + 32;
+    size_t dfdOffset = levelIndexOffset + levels.size() * 24;
+    size_t kvdOffset = dfdOffset + dfd.size();
+
+    std::vector<unsigned char> out(identifier, identifier + sizeof(identifier));
+    Append32(out, info.VkFormat);
+    Append32(out, 1);            // Type size, bytes are bytes
+    Append32(out, width);
+    Append32(out, height);
+    Append32(out, 0);            // Depth
+    Append32(out, 0);            // Layers
+    Append32(out, 1);            // Faces
+    Append32(out, (uint32_t)levels.size());
+    Append32(out, 0);            // No supercompression
+    Append32(out, (uint32_t)dfdOffset);
+    Append32(out, (uint32_t)dfd.size());
+    Append32(out, (uint32_t)kvdOffset);
+    Append32(out, (uint32_t)kvd.size());
+    Append64(out, 0);            // No supercompression global data
+    Append64(out, 0);
+
+    // Filled in below once the data offsets are known
+    size_t levelIndex = out.size();
+    out.resize(out.size() + levels.size() * 24);
+
+    out.insert(out.end(), dfd.begin(), dfd.end());
+    out.insert(out.end(), kvd.begin(), kvd.end());
+
+    // Smallest level first, each aligned to the block size and 4
+    size_t alignment = info.BytesPerBlock < 4 ? 4 : info.BytesPerBlock;
+    for (size_t i = levels.size(); i-- > 0; )
+    {
+        Pad(out, alignment);
+        std::vector<unsigned char> entry;
+        Append64(entry, out.size());
+        Append64(entry, levels[i].size());
+        Append64(entry, levels[i].size());
+        memcpy(out.data() + levelIndex + i * 24, entry.data(), 24);
+
+        out.insert(out.end(), levels[i].begin(), levels[i].end());
+    }
+
+    std::ofstream stream(path, std::ios::binary);
+    stream.write((const char*)out.data(), out.size());
+    return (bool)stream;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // The same flip the runtime used to do on every load
+    stbi_set_flip_vertically_on_load(options.Flip ? 1 : 0);
+    int width, height, bpp;
+    unsigned char* pixels = stbi_load(options.Input.c_str(), &width, &height, &bpp, 4);
+    if (!pixels)
+    {
+        std::cout << "Failed to load " << options.Input << ": " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+
+    std::vector<MipLevel> chain;
+    if (options.Mips)
+        chain = GenerateMipChain(pixels, width, height, options.Filter);
+
+    std::vector<std::vector<unsigned char>> levels;
+    levels.emplace_back(pixels, pixels + (size_t)width * height * 4);
+    for (MipLevel& level : chain)
+        levels.push_back(std::move(level.Pixels));
+    stbi_image_free(pixels);
+
+    if (options.Format != OutputFormat::RGBA8)
+    {
+        BlockFormat blockFormat = options.Format == OutputFormat::BC1 ? BlockFormat::BC1 : BlockFormat::BC3;
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            int levelWidth = std::max(width >> i, 1), levelHeight = std::max(height >> i, 1);
+            levels[i] = CompressImage(levels[i].data(), levelWidth, levelHeight, blockFormat);
+        }
+    }
+
+    if (!WriteKtx2(options.Output, options.Format, width, height, levels, options.Flip))
+    {
+        std::cout << "Failed to write " << options.Output << std::endl;
+        return 1;
+    }
+
+    size_t total = 0;
+    for (const auto& level : levels)
+        total += level.size();
+    std::cout << options.Input << " -> " << options.Output << ": " << width << "x" << height << ", " <<
+        levels.size() << " levels, " << total << " bytes" << std::endl;
+    return 0;
+}